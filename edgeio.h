@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "sobel_kernels.h"
+
+// Sparse edge-list file (.edg) written from an edge_list
+//
+// Text header:  "SBE1\n<cols> <rows>\n<threshold>\n<count>\n"
+// Then for every row: varint(number of edges), followed per edge by
+// varint(column gap since the previous edge's column + 1) and one magnitude
+// byte. Varints are 7 bits per byte, low bits first, high bit = continue.
+//
+// Rows are encoded in parallel blocks; a prefix sum over the block sizes
+// gives each block its file offset and the blocks are written with pwrite.
+
+static unsigned char *edge_put_varint(unsigned char *p, unsigned long v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static const unsigned char *edge_get_varint(const unsigned char *p, const unsigned char *end, unsigned long *v) {
+    unsigned long result = 0;
+    int shift = 0;
+    while (p < end && shift < 64) {
+        unsigned char byte = *p++;
+        result |= (unsigned long)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) { *v = result; return p; }
+        shift += 7;
+    }
+    return NULL;
+}
+
+// Write an edge list; returns the number of bytes written, or -1
+long edgewrite(const char *filename, const edge_list *e) {
+    char header[128];
+    int header_len = snprintf(header, sizeof(header), "SBE1\n%d %d\n%.9g\n%ld\n",
+                              e->cols, e->rows, e->threshold, e->count);
+
+    int num_blocks = 1;
+#ifdef _OPENMP
+    num_blocks = omp_get_max_threads();
+#endif
+    if (num_blocks > e->rows) num_blocks = e->rows > 0 ? e->rows : 1;
+
+    unsigned char **blocks = (unsigned char **)calloc(num_blocks, sizeof(unsigned char *));
+    long *offsets = (long *)calloc(num_blocks + 1, sizeof(long));
+    if (!blocks || !offsets) { free(blocks); free(offsets); return -1; }
+
+    // Encode: worst case is 5 bytes per row count and 6 per edge
+    int failed = 0;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:failed)
+#endif
+    for (int b = 0; b < num_blocks; b++) {
+        int r0 = (int)((long)e->rows * b / num_blocks);
+        int r1 = (int)((long)e->rows * (b + 1) / num_blocks);
+        long edges = e->row_ptr[r1] - e->row_ptr[r0];
+        blocks[b] = (unsigned char *)malloc(5 * (size_t)(r1 - r0) + 6 * (size_t)edges + 1);
+        if (!blocks[b]) { failed++; continue; }
+
+        unsigned char *p = blocks[b];
+        for (int i = r0; i < r1; i++) {
+            p = edge_put_varint(p, (unsigned long)(e->row_ptr[i + 1] - e->row_ptr[i]));
+            int next_col = 0;
+            for (long k = e->row_ptr[i]; k < e->row_ptr[i + 1]; k++) {
+                p = edge_put_varint(p, (unsigned long)(e->col[k] - next_col));
+                *p++ = e->mag[k];
+                next_col = e->col[k] + 1;
+            }
+        }
+        offsets[b + 1] = (long)(p - blocks[b]);
+    }
+
+    long total = -1;
+    int fd = failed ? -1 : open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        offsets[0] = header_len;
+        for (int b = 0; b < num_blocks; b++) offsets[b + 1] += offsets[b];
+
+        int write_failed = pwrite(fd, header, header_len, 0) != header_len;
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) reduction(+:write_failed)
+#endif
+        for (int b = 0; b < num_blocks; b++) {
+            size_t len = (size_t)(offsets[b + 1] - offsets[b]);
+            if (pwrite(fd, blocks[b], len, offsets[b]) != (ssize_t)len) write_failed++;
+        }
+        if (close(fd) == 0 && !write_failed) total = offsets[num_blocks];
+    } else if (!failed) {
+        perror("open");
+    }
+
+    for (int b = 0; b < num_blocks; b++) free(blocks[b]);
+    free(blocks);
+    free(offsets);
+    return total;
+}
+
+// Read an edge list written by edgewrite (arrays allocated inside)
+int edgeread(const char *filename, edge_list *e) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) { perror("fopen"); return -1; }
+
+    char magic[5];
+    if (fscanf(f, "%4s %d %d %f %ld", magic, &e->cols, &e->rows, &e->threshold, &e->count) != 5 ||
+        strcmp(magic, "SBE1") != 0 || fgetc(f) != '\n') {
+        fclose(f);
+        return -1;
+    }
+
+    long start = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f) - start;
+    fseek(f, start, SEEK_SET);
+
+    unsigned char *data = (unsigned char *)malloc(size > 0 ? size : 1);
+    e->row_ptr = (long *)malloc((e->rows + 1) * sizeof(long));
+    e->col = (int *)malloc((e->count > 0 ? e->count : 1) * sizeof(int));
+    e->mag = (unsigned char *)malloc(e->count > 0 ? e->count : 1);
+    int ok = data && e->row_ptr && e->col && e->mag && fread(data, 1, size, f) == (size_t)size;
+    fclose(f);
+
+    const unsigned char *p = data, *end = data + size;
+    long k = 0;
+    if (ok) e->row_ptr[0] = 0;
+    for (int i = 0; ok && i < e->rows; i++) {
+        unsigned long n, gap;
+        if (!(p = edge_get_varint(p, end, &n)) || k + (long)n > e->count) { ok = 0; break; }
+        int next_col = 0;
+        for (unsigned long m = 0; m < n; m++) {
+            if (!(p = edge_get_varint(p, end, &gap)) || p >= end) { ok = 0; break; }
+            e->col[k] = next_col + (int)gap;
+            e->mag[k] = *p++;
+            next_col = e->col[k] + 1;
+            k++;
+        }
+        e->row_ptr[i + 1] = k;
+    }
+    free(data);
+
+    if (!ok || k != e->count) {
+        free(e->row_ptr);
+        free(e->col);
+        free(e->mag);
+        return -1;
+    }
+    return 0;
+}
+
+// Write a bitmask (rows x ((cols + 7) / 8) bytes, MSB first) as binary PBM
+int pbmwrite(const char *filename, const unsigned char *mask, int rows, int cols) {
+    FILE *f = fopen(filename, "wb");
+    if (!f) { perror("fopen"); return -1; }
+    fprintf(f, "P4\n%d %d\n", cols, rows);
+    size_t bytes = (size_t)rows * ((cols + 7) / 8);
+    int ok = fwrite(mask, 1, bytes, f) == bytes;
+    fclose(f);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pgmio.h"
+#include "edgeio.h"
+
+// Helper for test_regression.sh:
+//   gen     writes synthetic test images (any size, several patterns)
+//   patch   inverts a few rectangles of an image (incremental-frame tests)
+//   ref     runs a plain-loop blur + Sobel that shares no code with the
+//           kernel layer, as an independent reference (optionally per
+//           pyramid level)
+//   diff    compares two PGM files pixel by pixel with a tolerance,
+//           optionally only inside a window
+//   orient  checks a direction map against libm atan2
+//   edges   checks an edge list (and PBM mask) against the thresholded
+//           reference magnitudes
+
+// Synthetic image patterns
+static float gen_pixel(const char *pattern, int i, int j, int rows, int cols, unsigned int *state) {
+    if (strcmp(pattern, "gradient") == 0) return 255.0f * (i + j) / (rows + cols);
+    if (strcmp(pattern, "checker") == 0) return ((i / 8 + j / 8) % 2) ? 255.0f : 0.0f;
+    if (strcmp(pattern, "step") == 0) return (j > cols / 3 && i < 2 * rows / 3) ? 200.0f : 30.0f;
+    if (strcmp(pattern, "flat") == 0) return 128.0f;
+    // noise: xorshift32
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return (float)(*state & 0xff);
+}
+
+static int run_gen(int rows, int cols, const char *pattern, unsigned int seed, const char *filename) {
+    float *img = (float *)malloc((size_t)rows * cols * sizeof(float));
+    if (!img) {
+        fprintf(stderr, "Error: Failed to allocate image\n");
+        return 1;
+    }
+    unsigned int state = seed ? seed : 1;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            img[(size_t)i * cols + j] = gen_pixel(pattern, i, j, rows, cols, &state);
+        }
+    }
+    int status = pgmwrite(filename, img, rows, cols, 1) == 0 ? 0 : 1;
+    free(img);
+    return status;
+}
+
+// Invert the pixels of each rectangle (clipped to the image), so every pixel
+// inside changes unless it was exactly mid-gray
+static int run_patch(const char *in_file, const char *out_file, char **rects, int num_rects) {
+    float *img = NULL;
+    int rows, cols;
+    if (pgmread(in_file, &img, &rows, &cols) != 0) {
+        fprintf(stderr, "Error: Failed to read %s\n", in_file);
+        return 1;
+    }
+    for (int k = 0; k < num_rects; k++) {
+        int r0 = atoi(rects[4 * k]), c0 = atoi(rects[4 * k + 1]);
+        int r1 = r0 + atoi(rects[4 * k + 2]), c1 = c0 + atoi(rects[4 * k + 3]);
+        for (int i = r0 < 0 ? 0 : r0; i < r1 && i < rows; i++) {
+            for (int j = c0 < 0 ? 0 : c0; j < c1 && j < cols; j++) {
+                img[(size_t)i * cols + j] = 255.0f - img[(size_t)i * cols + j];
+            }
+        }
+    }
+    int status = pgmwrite(out_file, img, rows, cols, 1) == 0 ? 0 : 1;
+    free(img);
+    return status;
+}
+
+// Reference filter: the original straightforward loops, serial, with the
+// same border rules (blur copies the frame, Sobel zeroes it). If gx / gy are
+// not NULL they receive the interior gradient sums.
+static void ref_filter(const float *in, float *blurred, float *out, float *gx, float *gy, int rows, int cols) {
+    const int Gx[3][3] = { {-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1} };
+    const int Gy[3][3] = { {-1, -2, -1}, {0, 0, 0}, {1, 2, 1} };
+
+    memcpy(blurred, in, (size_t)rows * cols * sizeof(float));
+    memset(out, 0, (size_t)rows * cols * sizeof(float));
+    for (int i = 1; i < rows - 1; i++) {
+        for (int j = 1; j < cols - 1; j++) {
+            float sum = 0.0f;
+            for (int ki = -1; ki <= 1; ki++) {
+                for (int kj = -1; kj <= 1; kj++) {
+                    sum += in[(size_t)(i + ki) * cols + (j + kj)];
+                }
+            }
+            blurred[(size_t)i * cols + j] = sum * (1.0f / 9.0f);
+        }
+    }
+    for (int i = 1; i < rows - 1; i++) {
+        for (int j = 1; j < cols - 1; j++) {
+            float sum_x = 0.0f, sum_y = 0.0f;
+            for (int ki = -1; ki <= 1; ki++) {
+                for (int kj = -1; kj <= 1; kj++) {
+                    float pixel = blurred[(size_t)(i + ki) * cols + (j + kj)];
+                    sum_x += pixel * Gx[ki + 1][kj + 1];
+                    sum_y += pixel * Gy[ki + 1][kj + 1];
+                }
+            }
+            out[(size_t)i * cols + j] = sqrtf(sum_x * sum_x + sum_y * sum_y);
+            if (gx) gx[(size_t)i * cols + j] = sum_x;
+            if (gy) gy[(size_t)i * cols + j] = sum_y;
+        }
+    }
+}
+
+// Level 0 goes to out_file; with levels > 1, level k (the 2x2 mean of level
+// k-1's blurred image, filtered again) goes to <out_file>_L<k>.pgm
+static int run_ref(const char *in_file, const char *out_file, int levels) {
+    float *in = NULL;
+    int rows, cols;
+    if (pgmread(in_file, &in, &rows, &cols) != 0) {
+        fprintf(stderr, "Error: Failed to read %s\n", in_file);
+        return 1;
+    }
+    size_t n = (size_t)rows * cols;
+    float *blurred = (float *)malloc(n * sizeof(float));
+    float *out = (float *)malloc(n * sizeof(float));
+    if (!blurred || !out) {
+        fprintf(stderr, "Error: Failed to allocate image buffers\n");
+        free(in);
+        free(blurred);
+        free(out);
+        return 1;
+    }
+
+    char base[256];
+    snprintf(base, sizeof(base), "%s", out_file);
+    char *ext = strrchr(base, '.');
+    if (ext && strcmp(ext, ".pgm") == 0) *ext = '\0';
+
+    int status = 0;
+    // Like sobel_omp --pyramid, stop before a level gets smaller than 3x3
+    for (int k = 0; k < levels && status == 0 && (k == 0 || (rows >= 3 && cols >= 3)); k++) {
+        ref_filter(in, blurred, out, NULL, NULL, rows, cols);
+
+        char level_file[300];
+        if (k == 0) snprintf(level_file, sizeof(level_file), "%s", out_file);
+        else snprintf(level_file, sizeof(level_file), "%s_L%d.pgm", base, k);
+        if (pgmwrite(level_file, out, rows, cols, 1) != 0) status = 1;
+
+        // Next level: 2x2 mean of this level's blurred image
+        int down_rows = rows / 2, down_cols = cols / 2;
+        for (int i = 0; i < down_rows; i++) {
+            for (int j = 0; j < down_cols; j++) {
+                const float *p = blurred + (size_t)(2 * i) * cols + 2 * j;
+                in[(size_t)i * down_cols + j] = (p[0] + p[1] + p[cols] + p[cols + 1]) * 0.25f;
+            }
+        }
+        rows = down_rows;
+        cols = down_cols;
+    }
+
+    free(in);
+    free(blurred);
+    free(out);
+    return status;
+}
+
+// Direction codes against libm atan2 of the reference gradients. With 4 or 8
+// bins a code may only differ within 1e-3 rad of a bin edge; 256-step
+// angles may be one step off. Returns 0 when all pixels pass.
+static int run_orient(const char *in_file, const char *dir_file, int bins) {
+    float *in = NULL, *dir = NULL;
+    int rows, cols, dir_rows, dir_cols;
+    if (pgmread(in_file, &in, &rows, &cols) != 0 || pgmread(dir_file, &dir, &dir_rows, &dir_cols) != 0) {
+        fprintf(stderr, "Error: Failed to read %s or %s\n", in_file, dir_file);
+        free(in);
+        return 2;
+    }
+    size_t n = (size_t)rows * cols;
+    float *blurred = (float *)malloc(n * sizeof(float));
+    float *out = (float *)malloc(n * sizeof(float));
+    float *gx = (float *)calloc(n, sizeof(float));
+    float *gy = (float *)calloc(n, sizeof(float));
+    if (!blurred || !out || !gx || !gy || dir_rows != rows || dir_cols != cols) {
+        fprintf(stderr, "Error: Size mismatch or failed to allocate buffers\n");
+        free(in); free(dir); free(blurred); free(out); free(gx); free(gy);
+        return 2;
+    }
+    ref_filter(in, blurred, out, gx, gy, rows, cols);
+
+    const double two_pi = 6.283185307179586;
+    int steps = bins == 256 ? 256 : 8;
+    long bad = 0;
+    int first_i = -1, first_j = -1;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            size_t k = (size_t)i * cols + j;
+            double angle = (gx[k] == 0.0f && gy[k] == 0.0f) ? 0.0 : atan2(gy[k], gx[k]);
+            if (angle < 0.0) angle += two_pi;
+            double pos = angle * steps / two_pi;
+            int expected = (int)floor(pos + 0.5) % steps;
+            int got = (int)dir[k];
+            if (bins == 4) expected &= 3;
+
+            int dist = abs(got - expected);
+            int period = bins == 4 ? 4 : steps;
+            if (period - dist < dist) dist = period - dist;
+            double edge = fabs(pos + 0.5 - floor(pos + 0.5)) * two_pi / steps;
+            int ok = dist == 0 || (dist == 1 && (bins == 256 || edge < 1e-3 || two_pi / steps - edge < 1e-3));
+            if (!ok && bad++ == 0) {
+                first_i = i;
+                first_j = j;
+            }
+        }
+    }
+    printf("%ld of %ld direction code(s) wrong", bad, (long)n);
+    if (bad > 0) printf(", first at row %d col %d", first_i, first_j);
+    printf("\n");
+    free(in); free(dir); free(blurred); free(out); free(gx); free(gy);
+    return bad > 0 ? 1 : 0;
+}
+
+// Returns 0 when every pixel is within 'tolerance' gray levels. If win is
+// not NULL only rows [win[0], win[0]+win[2]) x cols [win[1], win[1]+win[3])
+// are compared.
+static int run_diff(const char *file_a, const char *file_b, int tolerance, const int *win) {
+    float *a = NULL, *b = NULL;
+    int rows_a, cols_a, rows_b, cols_b;
+    if (pgmread(file_a, &a, &rows_a, &cols_a) != 0 || pgmread(file_b, &b, &rows_b, &cols_b) != 0) {
+        fprintf(stderr, "Error: Failed to read %s or %s\n", file_a, file_b);
+        free(a);
+        return 2;
+    }
+    if (rows_a != rows_b || cols_a != cols_b) {
+        printf("size mismatch: %dx%d vs %dx%d\n", cols_a, rows_a, cols_b, rows_b);
+        free(a);
+        free(b);
+        return 1;
+    }
+
+    int i0 = 0, i1 = rows_a, j0 = 0, j1 = cols_a;
+    if (win) {
+        if (win[0] < 0 || win[1] < 0 || win[2] <= 0 || win[3] <= 0 ||
+            win[0] + win[2] > rows_a || win[1] + win[3] > cols_a) {
+            printf("window outside the %dx%d image\n", cols_a, rows_a);
+            free(a);
+            free(b);
+            return 1;
+        }
+        i0 = win[0]; i1 = win[0] + win[2];
+        j0 = win[1]; j1 = win[1] + win[3];
+    }
+
+    long over = 0, differ = 0;
+    int max_diff = 0, first_i = -1, first_j = -1;
+    for (int i = i0; i < i1; i++) {
+        for (int j = j0; j < j1; j++) {
+            int d = abs((int)a[(size_t)i * cols_a + j] - (int)b[(size_t)i * cols_a + j]);
+            if (d > 0) differ++;
+            if (d > tolerance) {
+                if (over++ == 0) {
+                    first_i = i;
+                    first_j = j;
+                }
+            }
+            if (d > max_diff) max_diff = d;
+        }
+    }
+    printf("max diff %d, %ld pixel(s) differ, %ld over tolerance %d", max_diff, differ, over, tolerance);
+    if (over > 0) printf(", first at row %d col %d", first_i, first_j);
+    printf("\n");
+    free(a);
+    free(b);
+    return over > 0 ? 1 : 0;
+}
+
+// Read a binary PBM (P4) written by pbmwrite
+static unsigned char *pbmread(const char *filename, int *rows, int *cols) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return NULL;
+    char magic[3];
+    unsigned char *mask = NULL;
+    if (fscanf(f, "%2s %d %d", magic, cols, rows) == 3 && strcmp(magic, "P4") == 0 &&
+        fgetc(f) != EOF && *rows > 0 && *cols > 0) {
+        size_t bytes = (size_t)*rows * ((*cols + 7) / 8);
+        mask = (unsigned char *)malloc(bytes);
+        if (mask && fread(mask, 1, bytes, f) != bytes) {
+            free(mask);
+            mask = NULL;
+        }
+    }
+    fclose(f);
+    return mask;
+}
+
+// Edge list against the reference: every interior pixel whose magnitude is
+// >= the file's threshold must be listed, with its magnitude byte within
+// 'tolerance', and nothing else; the mask (if given) must mark the same
+// pixels. Pixels within 1e-3 of the threshold may go either way.
+static int run_edges(const char *in_file, const char *edge_file, const char *mask_file, int tolerance) {
+    float *in = NULL;
+    int rows, cols;
+    edge_list e;
+    if (pgmread(in_file, &in, &rows, &cols) != 0 || edgeread(edge_file, &e) != 0) {
+        fprintf(stderr, "Error: Failed to read %s or %s\n", in_file, edge_file);
+        free(in);
+        return 2;
+    }
+    size_t n = (size_t)rows * cols;
+    float *blurred = (float *)malloc(n * sizeof(float));
+    float *out = (float *)malloc(n * sizeof(float));
+    unsigned char *mask = NULL;
+    int mask_rows = rows, mask_cols = cols;
+    if (mask_file) mask = pbmread(mask_file, &mask_rows, &mask_cols);
+    if (!blurred || !out || e.rows != rows || e.cols != cols ||
+        (mask_file && (!mask || mask_rows != rows || mask_cols != cols))) {
+        fprintf(stderr, "Error: Size mismatch, unreadable mask or failed to allocate buffers\n");
+        free(in); free(blurred); free(out); free(mask);
+        free(e.row_ptr); free(e.col); free(e.mag);
+        return 2;
+    }
+    ref_filter(in, blurred, out, NULL, NULL, rows, cols);
+
+    long bad = 0, expected_count = 0;
+    int first_i = -1, first_j = -1;
+    long mask_stride = (cols + 7) / 8;
+    for (int i = 0; i < rows; i++) {
+        long k = e.row_ptr[i];
+        for (int j = 0; j < cols; j++) {
+            float mag = out[(size_t)i * cols + j];
+            int interior = i > 0 && i < rows - 1 && j > 0 && j < cols - 1;
+            int expected = interior && mag >= e.threshold;
+            int listed = k < e.row_ptr[i + 1] && e.col[k] == j;
+            int ok = listed == expected || (interior && fabsf(mag - e.threshold) < 1e-3f);
+            if (listed) {
+                int val = (int)(mag + 0.5f);
+                if (val > 255) val = 255;
+                if (abs(val - (int)e.mag[k]) > tolerance) ok = 0;
+                k++;
+            }
+            if (mask) {
+                int bit = (mask[i * mask_stride + (j >> 3)] >> (7 - (j & 7))) & 1;
+                if (bit != listed) ok = 0;
+            }
+            expected_count += expected;
+            if (!ok && bad++ == 0) {
+                first_i = i;
+                first_j = j;
+            }
+        }
+        // Columns out of order or out of range are left unconsumed
+        if (k != e.row_ptr[i + 1] && bad++ == 0) {
+            first_i = i;
+            first_j = cols;
+        }
+    }
+    printf("%ld edge pixel(s) listed, %ld expected at threshold %g, %ld wrong", e.count, expected_count,
+           e.threshold, bad);
+    if (bad > 0) printf(", first at row %d col %d", first_i, first_j);
+    printf("\n");
+    free(in); free(blurred); free(out); free(mask);
+    free(e.row_ptr); free(e.col); free(e.mag);
+    return bad > 0 ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 7 && strcmp(argv[1], "gen") == 0) {
+        int rows = atoi(argv[2]), cols = atoi(argv[3]);
+        if (rows <= 0 || cols <= 0) {
+            fprintf(stderr, "Error: Invalid image size\n");
+            return 1;
+        }
+        return run_gen(rows, cols, argv[4], (unsigned int)strtoul(argv[5], NULL, 10), argv[6]);
+    }
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "ref") == 0) {
+        int levels = argc == 5 ? atoi(argv[4]) : 1;
+        return run_ref(argv[2], argv[3], levels > 0 ? levels : 1);
+    }
+    if (argc == 5 && strcmp(argv[1], "orient") == 0) {
+        return run_orient(argv[2], argv[3], atoi(argv[4]));
+    }
+    if (argc >= 8 && (argc - 4) % 4 == 0 && strcmp(argv[1], "patch") == 0) {
+        return run_patch(argv[2], argv[3], argv + 4, (argc - 4) / 4);
+    }
+    if ((argc == 4 || argc == 5 || argc == 9) && strcmp(argv[1], "diff") == 0) {
+        int win[4];
+        for (int k = 0; argc == 9 && k < 4; k++) win[k] = atoi(argv[5 + k]);
+        return run_diff(argv[2], argv[3], argc >= 5 ? atoi(argv[4]) : 0, argc == 9 ? win : NULL);
+    }
+    if ((argc == 4 || argc == 5 || argc == 6) && strcmp(argv[1], "edges") == 0) {
+        const char *mask_file = argc >= 5 && strcmp(argv[4], "-") != 0 ? argv[4] : NULL;
+        return run_edges(argv[2], argv[3], mask_file, argc == 6 ? atoi(argv[5]) : 0);
+    }
+    fprintf(stderr, "Usage: %s gen <rows> <cols> noise|gradient|checker|step|flat <seed> <out.pgm>\n", argv[0]);
+    fprintf(stderr, "       %s ref <in.pgm> <out.pgm> [pyramid_levels]\n", argv[0]);
+    fprintf(stderr, "       %s patch <in.pgm> <out.pgm> <row> <col> <height> <width> [...]\n", argv[0]);
+    fprintf(stderr, "       %s diff <a.pgm> <b.pgm> [tolerance [row col height width]]\n", argv[0]);
+    fprintf(stderr, "       %s orient <in.pgm> <direction.pgm> 4|8|256\n", argv[0]);
+    fprintf(stderr, "       %s edges <in.pgm> <edges.edg> [mask.pbm|- [tolerance]]\n", argv[0]);
+    return 1;
+}
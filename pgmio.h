@@ -1,6 +1,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#include <unistd.h>
+#endif
+
+// Binary outputs at least this large are written as parallel row bands
+#define PGM_PARALLEL_WRITE_BYTES (4 << 20)
+
+// Round, clamp and narrow floats to 8-bit pixels (branchless so it vectorizes)
+static void pgm_narrow(const float *src, unsigned char *dst, size_t n) {
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++) {
+        int val = (int)(src[i] + 0.5f);
+        val = val < 0 ? 0 : val;
+        val = val > 255 ? 255 : val;
+        dst[i] = (unsigned char)val;
+    }
+}
 
 // Read PGM (P2 or P5) into float array (allocated inside)
 int pgmread(const char *filename, float **img, int *rows, int *cols) {
@@ -37,7 +57,11 @@ int pgmread(const char *filename, float **img, int *rows, int *cols) {
         unsigned char *tmp = malloc(w*h);
         if(!tmp) { fclose(f); free(*img); return -1; }
         if(fread(tmp,1,w*h,f)!=(size_t)(w*h)) { fclose(f); free(*img); free(tmp); return -1; }
-        for(int i=0;i<w*h;i++) (*img)[i]=(float)tmp[i];
+        float *out = *img;
+#ifdef _OPENMP
+        #pragma omp parallel for simd schedule(static)
+#endif
+        for(int i=0;i<w*h;i++) out[i]=(float)tmp[i];
         free(tmp);
     } else if(strcmp(magic,"P2")==0) {
         for(int i=0;i<w*h;i++) {
@@ -62,14 +86,36 @@ int pgmwrite(const char *filename, const float *img, int rows, int cols, int bin
 
     if(binary) {
         fprintf(f,"P5\n%d %d\n255\n", cols, rows);
+#ifdef _OPENMP
+        // Large images: each thread narrows a band of rows and writes it with
+        // pwrite at its known offset after the header
+        if((size_t)rows*cols >= PGM_PARALLEL_WRITE_BYTES && omp_get_max_threads() > 1) {
+            fflush(f);
+            long header = ftell(f);
+            int fd = fileno(f);
+            int bands = omp_get_max_threads() * 4;
+            int failed = 0;
+            #pragma omp parallel for schedule(dynamic) reduction(+:failed)
+            for(int b=0;b<bands;b++) {
+                int r0 = (int)((long)rows*b/bands);
+                int r1 = (int)((long)rows*(b+1)/bands);
+                size_t n = (size_t)(r1-r0)*cols;
+                unsigned char *band = malloc(n ? n : 1);
+                if(!band) { failed++; continue; }
+                pgm_narrow(img+(size_t)r0*cols, band, n);
+                if(pwrite(fd, band, n, header+(long)r0*cols)!=(ssize_t)n) failed++;
+                free(band);
+            }
+            fclose(f);
+            return failed ? -1 : 0;
+        }
+#endif
         unsigned char *tmp = malloc(rows*cols);
         if(!tmp) { fclose(f); return -1; }
-        for(int i=0;i<rows*cols;i++) {
-            int val = (int)(img[i]+0.5f);
-            if(val<0) val=0;
-            if(val>255) val=255;
-            tmp[i]=(unsigned char)val;
-        }
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static)
+#endif
+        for(int r=0;r<rows;r++) pgm_narrow(img+(size_t)r*cols, tmp+(size_t)r*cols, cols);
         fwrite(tmp,1,rows*cols,f);
         free(tmp);
     } else {
@@ -87,3 +133,13 @@ int pgmwrite(const char *filename, const float *img, int rows, int cols, int bin
     fclose(f);
     return 0;
 }
+
+// Write 8-bit codes as binary PGM with the given maxval (e.g. bin indices)
+int pgmwrite_bytes(const char *filename, const unsigned char *img, int rows, int cols, int maxval) {
+    FILE *f = fopen(filename, "wb");
+    if(!f) { perror("fopen"); return -1; }
+    fprintf(f,"P5\n%d %d\n%d\n", cols, rows, maxval);
+    int ok = fwrite(img,1,(size_t)rows*cols,f)==(size_t)rows*cols;
+    fclose(f);
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pgmio.h"
+#include "tileio.h"
+
+// Convert between PGM and the tiled .pgt container (see tileio.h)
+//   ./pgmtile to-tiled sample_16k.pgm sample_16k.pgt [tile_size]
+//   ./pgmtile to-pgm output/sobel_omp_16k.pgt output/sobel_omp_16k.pgm
+
+int main(int argc, char *argv[]) {
+    if (argc < 4 || argc > 5) {
+        fprintf(stderr, "Usage: %s to-tiled <in.pgm> <out.pgt> [tile_size]\n", argv[0]);
+        fprintf(stderr, "       %s to-pgm <in.pgt> <out.pgm>\n", argv[0]);
+        return 1;
+    }
+
+    float *img;
+    int rows, cols;
+
+    if (strcmp(argv[1], "to-tiled") == 0) {
+        int tile = argc == 5 ? atoi(argv[4]) : TILE_DEFAULT_SIZE;
+        if (tile <= 0) {
+            fprintf(stderr, "Invalid tile size\n");
+            return 1;
+        }
+        if (pgmread(argv[2], &img, &rows, &cols) != 0) {
+            fprintf(stderr, "Failed to read %s\n", argv[2]);
+            return 1;
+        }
+
+        tiled_image t;
+        if (tileio_create(argv[3], rows, cols, tile, tile, &t) != 0) {
+            fprintf(stderr, "Failed to create %s\n", argv[3]);
+            free(img);
+            return 1;
+        }
+        int failed = 0;
+        for (int ty = 0; ty < t.tiles_y; ty++) {
+            for (int tx = 0; tx < t.tiles_x; tx++) {
+                if (tileio_write_tile(&t, ty, tx, img, 0, 0, cols) != 0) failed = 1;
+            }
+        }
+        tileio_close(&t);
+        free(img);
+        if (failed) {
+            fprintf(stderr, "Failed to write %s\n", argv[3]);
+            return 1;
+        }
+        printf("Wrote %dx%d image as %dx%d tiles to %s\n", cols, rows, tile, tile, argv[3]);
+    } else if (strcmp(argv[1], "to-pgm") == 0 && argc == 4) {
+        tiled_image t;
+        if (tileio_open(argv[2], &t) != 0) {
+            fprintf(stderr, "Failed to open %s\n", argv[2]);
+            return 1;
+        }
+        rows = t.rows;
+        cols = t.cols;
+        img = (float *)malloc((size_t)rows * cols * sizeof(float));
+        if (!img || tileio_read_region(&t, 0, 0, rows, cols, img) != 0) {
+            fprintf(stderr, "Failed to read %s\n", argv[2]);
+            free(img);
+            tileio_close(&t);
+            return 1;
+        }
+        tileio_close(&t);
+        if (pgmwrite(argv[3], img, rows, cols, 1) != 0) {
+            fprintf(stderr, "Failed to write %s\n", argv[3]);
+            free(img);
+            return 1;
+        }
+        printf("Wrote %dx%d image to %s\n", cols, rows, argv[3]);
+        free(img);
+    } else {
+        fprintf(stderr, "Unknown command '%s'\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
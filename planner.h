@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <omp.h>
+#include "sobel_kernels.h"
+
+// Execution planner: picks serial / threaded / fused / tiled execution, the
+// thread count and the band / tile size from the image size and a host
+// profile (cores, caches, NUMA nodes, calibrated kernel speed). The profile
+// is probed once and cached in a small key=value file.
+
+#define PROFILE_DEFAULT_PATH ".sobel_profile"
+#define PROFILE_CALIBRATION_SIZE 256
+
+typedef struct {
+    int cores;
+    long l1d_bytes, l2_bytes, l3_bytes;
+    int numa_nodes;
+    double pixel_ns;        // single-thread blur + Sobel cost per pixel
+    double region_us;       // cost of one parallel region with all cores
+} host_profile;
+
+typedef enum { STRATEGY_SERIAL, STRATEGY_THREADED, STRATEGY_FUSED, STRATEGY_TILED } strategy_t;
+
+static const char *strategy_names[] = { "serial", "threaded", "fused", "tiled" };
+
+typedef struct {
+    strategy_t strategy;
+    int threads;
+    int band_rows;          // fused / tiled: output rows per task
+    int tile_cols;          // tiled: output columns per task (0 = full width)
+    char reason[512];
+} exec_plan;
+
+// Parse sizes like "32K" or "1024K" from sysfs
+static long profile_read_cache_size(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    long value = 0;
+    char unit = 0;
+    int n = fscanf(f, "%ld%c", &value, &unit);
+    fclose(f);
+    if (n < 1) return 0;
+    if (unit == 'K') value *= 1024;
+    else if (unit == 'M') value *= 1024 * 1024;
+    return value;
+}
+
+static void profile_probe_caches(host_profile *p) {
+    for (int idx = 0; idx < 8; idx++) {
+        char path[128], type[32] = "";
+        int level = 0;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        if (fscanf(f, "%d", &level) != 1) level = 0;
+        fclose(f);
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        f = fopen(path, "r");
+        if (f) {
+            if (fscanf(f, "%31s", type) != 1) type[0] = '\0';
+            fclose(f);
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        long size = profile_read_cache_size(path);
+        if (level == 1 && strcmp(type, "Instruction") != 0) p->l1d_bytes = size;
+        if (level == 2) p->l2_bytes = size;
+        if (level == 3) p->l3_bytes = size;
+    }
+}
+
+static int profile_count_numa_nodes(void) {
+    DIR *d = opendir("/sys/devices/system/node");
+    if (!d) return 1;
+    int nodes = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            nodes++;
+        }
+    }
+    closedir(d);
+    return nodes > 0 ? nodes : 1;
+}
+
+// Quick calibration: serial blur + Sobel on a synthetic image, and the cost
+// of entering an empty parallel region on every core
+static void profile_calibrate(host_profile *p) {
+    int n = PROFILE_CALIBRATION_SIZE;
+    float *in = (float *)malloc((size_t)n * n * sizeof(float));
+    float *tmp = (float *)malloc((size_t)n * n * sizeof(float));
+    float *out = (float *)malloc((size_t)n * n * sizeof(float));
+    p->pixel_ns = 5.0;
+    p->region_us = 5.0;
+    if (!in || !tmp || !out) { free(in); free(tmp); free(out); return; }
+
+    for (int i = 0; i < n * n; i++) in[i] = (float)((i * 2654435761u) >> 24);
+
+    int saved_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    double best = 1e30;
+    for (int rep = 0; rep < 5; rep++) {
+        double t0 = omp_get_wtime();
+        mean_blur(in, tmp, n, n);
+        sobel_filter(tmp, out, n, n);
+        double t = omp_get_wtime() - t0;
+        if (t < best) best = t;
+    }
+    p->pixel_ns = best * 1e9 / ((double)n * n);
+
+    omp_set_num_threads(p->cores);
+    int reps = 200;
+    volatile int sink = 0;
+    double t0 = omp_get_wtime();
+    for (int rep = 0; rep < reps; rep++) {
+        #pragma omp parallel
+        {
+            if (omp_get_thread_num() == 0) sink++;
+        }
+    }
+    p->region_us = (omp_get_wtime() - t0) * 1e6 / reps;
+    omp_set_num_threads(saved_threads);
+
+    free(in);
+    free(tmp);
+    free(out);
+}
+
+void profile_probe(host_profile *p) {
+    memset(p, 0, sizeof(*p));
+    p->cores = omp_get_num_procs();
+    profile_probe_caches(p);
+    if (p->l1d_bytes <= 0) p->l1d_bytes = 32 * 1024;
+    if (p->l2_bytes <= 0) p->l2_bytes = 256 * 1024;
+    p->numa_nodes = profile_count_numa_nodes();
+    profile_calibrate(p);
+}
+
+int profile_save(const char *path, const host_profile *p) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "cores=%d\nl1d_bytes=%ld\nl2_bytes=%ld\nl3_bytes=%ld\nnuma_nodes=%d\npixel_ns=%.6f\nregion_us=%.6f\n",
+            p->cores, p->l1d_bytes, p->l2_bytes, p->l3_bytes, p->numa_nodes, p->pixel_ns, p->region_us);
+    fclose(f);
+    return 0;
+}
+
+int profile_load(const char *path, host_profile *p) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    memset(p, 0, sizeof(*p));
+    char key[64];
+    double value;
+    int fields = 0;
+    while (fscanf(f, " %63[^=]=%lf", key, &value) == 2) {
+        if (strcmp(key, "cores") == 0) p->cores = (int)value;
+        else if (strcmp(key, "l1d_bytes") == 0) p->l1d_bytes = (long)value;
+        else if (strcmp(key, "l2_bytes") == 0) p->l2_bytes = (long)value;
+        else if (strcmp(key, "l3_bytes") == 0) p->l3_bytes = (long)value;
+        else if (strcmp(key, "numa_nodes") == 0) p->numa_nodes = (int)value;
+        else if (strcmp(key, "pixel_ns") == 0) p->pixel_ns = value;
+        else if (strcmp(key, "region_us") == 0) p->region_us = value;
+        else continue;
+        fields++;
+    }
+    fclose(f);
+    // A profile from a different machine (or a truncated file) is re-probed
+    if (fields < 7 || p->cores != omp_get_num_procs() || p->pixel_ns <= 0.0) return -1;
+    return 0;
+}
+
+// Load the cached profile, or probe the host and cache the result.
+// The path comes from $SOBEL_PROFILE, defaulting to ./.sobel_profile
+void profile_get(host_profile *p, int reprobe) {
+    const char *path = getenv("SOBEL_PROFILE");
+    if (!path || !*path) path = PROFILE_DEFAULT_PATH;
+    if (!reprobe && profile_load(path, p) == 0) return;
+    profile_probe(p);
+    if (profile_save(path, p) != 0) {
+        fprintf(stderr, "Warning: Could not save host profile to %s\n", path);
+    }
+}
+
+// Default fused / tiled band height: a few bands per thread for balance, at
+// least 16 rows so the two recomputed ring rows stay a small overhead
+int plan_default_band(int rows, int threads) {
+    int band = rows / (threads * 4);
+    return band < 16 ? 16 : band;
+}
+
+// Pick a plan for a rows x cols image. forced_threads > 0 fixes the thread
+// count (e.g. from OMP_NUM_THREADS); the strategy is still planned for it.
+void plan_execution(const host_profile *p, int rows, int cols, int forced_threads, exec_plan *plan) {
+    double pixels = (double)rows * cols;
+    double work_us = pixels * p->pixel_ns / 1000.0;
+
+    // Threads: minimise work / t plus the fork/join cost of the two
+    // parallel regions, which grows with the number of threads woken
+    int threads = 1;
+    if (forced_threads > 0) {
+        threads = forced_threads;
+    } else {
+        double best = work_us;
+        for (int t = 2; t <= p->cores; t++) {
+            double est = work_us / t + 2.0 * p->region_us * t / p->cores;
+            if (est < best) {
+                best = est;
+                threads = t;
+            }
+        }
+    }
+    plan->threads = threads;
+    plan->band_rows = 0;
+    plan->tile_cols = 0;
+
+    // Two-pass working set: input, blurred and output images
+    double working_set = 3.0 * pixels * sizeof(float);
+    long cache = p->l3_bytes > 0 ? p->l3_bytes : p->l2_bytes * p->cores;
+    // Fused per-task footprint: three input rows plus the three-row ring
+    double fused_rows_bytes = 6.0 * cols * sizeof(float);
+
+    int n = 0;
+    n += snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                  "%dx%d image, est. %.0f us serial work; ", cols, rows, work_us);
+
+    if (threads == 1) {
+        plan->strategy = STRATEGY_SERIAL;
+        if (forced_threads > 0) {
+            snprintf(plan->reason + n, sizeof(plan->reason) - n, "1 thread requested");
+        } else {
+            snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                     "parallel region cost (%.1f us) outweighs splitting the work", p->region_us);
+        }
+    } else if (working_set <= cache) {
+        plan->strategy = STRATEGY_THREADED;
+        n += snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                      "working set %.1f MB fits in %.1f MB cache, two passes on %d threads",
+                      working_set / 1e6, cache / 1e6, threads);
+    } else {
+        plan->band_rows = plan_default_band(rows, threads);
+
+        if (fused_rows_bytes <= p->l2_bytes / 2) {
+            plan->strategy = STRATEGY_FUSED;
+            n += snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                          "working set %.1f MB exceeds %.1f MB cache, fusing blur+Sobel in %d-row bands",
+                          working_set / 1e6, cache / 1e6, plan->band_rows);
+        } else {
+            // Tile width so that six tile rows fit in half of L2
+            int tile = (int)((p->l2_bytes / 2) / (6 * sizeof(float))) - 2;
+            tile = tile / 64 * 64;
+            plan->tile_cols = tile < 64 ? 64 : tile;
+            plan->strategy = STRATEGY_TILED;
+            n += snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                          "working set %.1f MB exceeds %.1f MB cache and full rows exceed L2, "
+                          "fused %d-row x %d-column tiles",
+                          working_set / 1e6, cache / 1e6, plan->band_rows, plan->tile_cols);
+        }
+        if (p->numa_nodes > 1 && n < (int)sizeof(plan->reason)) {
+            snprintf(plan->reason + n, sizeof(plan->reason) - n,
+                     "; %d NUMA nodes, static bands keep each thread on its first-touched rows",
+                     p->numa_nodes);
+        }
+    }
+}
+
+void plan_print_profile(const host_profile *p) {
+    printf("Host profile: %d cores, L1d %ld KB, L2 %ld KB, L3 %ld KB, %d NUMA node(s), "
+           "%.3f ns/pixel serial, %.1f us per parallel region\n",
+           p->cores, p->l1d_bytes / 1024, p->l2_bytes / 1024, p->l3_bytes / 1024,
+           p->numa_nodes, p->pixel_ns, p->region_us);
+}
@@ -1,8 +1,8 @@
 #!/bin/bash
 
 # --- Check for correct number of arguments ---
-if [ "$#" -ne 3 ]; then
-    echo "Usage: $0 <num_nodes> <tasks_per_node> <problem_size>"
+if [ "$#" -lt 3 ] || [ "$#" -gt 4 ]; then
+    echo "Usage: $0 <num_nodes> <tasks_per_node> <problem_size> [static|balanced|shm]"
     exit 1
 fi
 
@@ -10,11 +10,12 @@ fi
 NUM_NODES=$1
 TASKS_PER_NODE=$2
 PROBLEM_SIZE=$3
+MODE=${4:-static}
 TOTAL_TASKS=$(( NUM_NODES * TASKS_PER_NODE ))
 
 # --- Define job-specific variables ---
-JOB_NAME="SOBEL_MPI_${NUM_NODES}n_${TASKS_PER_NODE}t_${PROBLEM_SIZE}"
-OUTPUT_FILE="SOBEL_MPI_${NUM_NODES}n_${TASKS_PER_NODE}t_${PROBLEM_SIZE}_%j.out"
+JOB_NAME="SOBEL_MPI_${NUM_NODES}n_${TASKS_PER_NODE}t_${PROBLEM_SIZE}_${MODE}"
+OUTPUT_FILE="SOBEL_MPI_${NUM_NODES}n_${TASKS_PER_NODE}t_${PROBLEM_SIZE}_${MODE}_%j.out"
 EXECUTABLE="./sobel_mpi"
 
 # --- Create the Slurm job script using a heredoc ---
@@ -32,7 +33,7 @@ cat <<EOF > "sobel_mpi.job"
 scontrol show hostnames "\$SLURM_NODELIST" | awk '{print \$0" slots=${TASKS_PER_NODE}"}' > hostfile.txt
 
 # Run the MPI program
-mpiexec.openmpi --hostfile hostfile.txt -n ${TOTAL_TASKS} ${EXECUTABLE} ${PROBLEM_SIZE}
+mpiexec.openmpi --hostfile hostfile.txt -n ${TOTAL_TASKS} ${EXECUTABLE} ${PROBLEM_SIZE} ${MODE}
 
 # Clean up the hostfile
 rm hostfile.txt
@@ -6,96 +6,184 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "pgmio.h"
+#include "sobel_kernels.h"
 
 #define OUTPUT_DIR "output"
 
-// Apply 3x3 mean blur filter to reduce noise
-// This is a bonus feature that improves edge detection quality
-void mean_blur(const float *input, float *output, int rows, int cols) {
-    // 3x3 mean blur kernel: all weights are 1/9
-    const float kernel_weight = 1.0f / 9.0f;
-    
-    // Process each pixel (excluding 1-pixel border)
-    for (int i = 1; i < rows - 1; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum = 0.0f;
-            
-            // Apply 3x3 average filter
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    sum += input[(i + ki) * cols + (j + kj)];
+// ---------------------------------------------------------------------------
+// Incremental mode: successive frames only recompute the regions that changed
+// ---------------------------------------------------------------------------
+
+// Block size (pixels) used by the block-wise frame diff
+#define DIFF_BLOCK 32
+
+// Previous input, blurred and output buffers kept between frames
+typedef struct {
+    float *input;
+    float *blurred;
+    float *output;
+    int rows, cols;
+} incremental_state;
+
+// Grow a region by 'halo' pixels on every side, clamped to the image
+static region_t region_expand(region_t r, int halo, int rows, int cols) {
+    region_t e;
+    e.r0 = r.r0 - halo < 0 ? 0 : r.r0 - halo;
+    e.c0 = r.c0 - halo < 0 ? 0 : r.c0 - halo;
+    e.r1 = r.r1 + halo > rows ? rows : r.r1 + halo;
+    e.c1 = r.c1 + halo > cols ? cols : r.c1 + halo;
+    return e;
+}
+
+// Block-wise diff between the stored frame and a new one.
+// Dirty blocks in the same block row are merged into horizontal runs.
+// Returns the number of regions written to *regions (caller frees).
+int find_dirty_regions(const float *prev, const float *cur, int rows, int cols, region_t **regions) {
+    int block_rows = (rows + DIFF_BLOCK - 1) / DIFF_BLOCK;
+    int block_cols = (cols + DIFF_BLOCK - 1) / DIFF_BLOCK;
+    *regions = (region_t *)malloc((size_t)block_rows * block_cols * sizeof(region_t));
+    if (!*regions) return -1;
+
+    int count = 0;
+    for (int bi = 0; bi < block_rows; bi++) {
+        int r0 = bi * DIFF_BLOCK;
+        int r1 = r0 + DIFF_BLOCK > rows ? rows : r0 + DIFF_BLOCK;
+        int run_start = -1;
+
+        for (int bj = 0; bj <= block_cols; bj++) {
+            int dirty = 0;
+            if (bj < block_cols) {
+                int c0 = bj * DIFF_BLOCK;
+                int c1 = c0 + DIFF_BLOCK > cols ? cols : c0 + DIFF_BLOCK;
+                for (int i = r0; i < r1 && !dirty; i++) {
+                    if (memcmp(prev + (size_t)i * cols + c0, cur + (size_t)i * cols + c0,
+                               (c1 - c0) * sizeof(float)) != 0) {
+                        dirty = 1;
+                    }
                 }
             }
-            
-            // Store averaged pixel value
-            output[i * cols + j] = sum * kernel_weight;
+
+            if (dirty && run_start < 0) {
+                run_start = bj;
+            } else if (!dirty && run_start >= 0) {
+                region_t r;
+                r.r0 = r0;
+                r.r1 = r1;
+                r.c0 = run_start * DIFF_BLOCK;
+                r.c1 = bj * DIFF_BLOCK > cols ? cols : bj * DIFF_BLOCK;
+                (*regions)[count++] = r;
+                run_start = -1;
+            }
         }
     }
-    
-    // Handle borders - copy original values
-    // Top and bottom rows
-    for (int j = 0; j < cols; j++) {
-        output[j] = input[j];                          // top row
-        output[(rows - 1) * cols + j] = input[(rows - 1) * cols + j];  // bottom row
-    }
-    // Left and right columns
-    for (int i = 0; i < rows; i++) {
-        output[i * cols] = input[i * cols];                   // left column
-        output[i * cols + (cols - 1)] = input[i * cols + (cols - 1)];  // right column
-    }
+    return count;
 }
 
-// Apply Sobel operator to compute edge detection
-void sobel_filter(const float *input, float *output, int rows, int cols) {
-    // Sobel kernels for gradient computation
-    int Gx[3][3] = {
-        {-1, 0, 1},
-        {-2, 0, 2},
-        {-1, 0, 1}
-    };
-    
-    int Gy[3][3] = {
-        {-1, -2, -1},
-        { 0,  0,  0},
-        { 1,  2,  1}
-    };
-    
-    // Process each pixel (excluding 1-pixel border)
-    for (int i = 1; i < rows - 1; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum_x = 0.0f;
-            float sum_y = 0.0f;
-            
-            // Apply 3x3 convolution
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    float pixel = input[(i + ki) * cols + (j + kj)];
-                    sum_x += pixel * Gx[ki + 1][kj + 1];
-                    sum_y += pixel * Gy[ki + 1][kj + 1];
-                }
+// Order regions by first row, then by first column
+static int compare_regions(const void *a, const void *b) {
+    const region_t *x = (const region_t *)a, *y = (const region_t *)b;
+    if (x->r0 != y->r0) return (x->r0 > y->r0) - (x->r0 < y->r0);
+    return (x->c0 > y->c0) - (x->c0 < y->c0);
+}
+
+// Apply 'filter' to the union of the regions grown by 'halo'. Regions that
+// overlap after growing are merged row by row, so every pixel is computed
+// once. Rows are swept in order with an active list (sorted by column) of
+// the regions covering the current row, so the cost follows the changed
+// area rather than rows x regions. Returns the number of pixels computed,
+// or -1 on error.
+static long filter_union(const float *input, float *output, int rows, int cols,
+                         const region_t *regions, int num_regions, int halo,
+                         void (*filter)(const float *, float *, int, int, region_t)) {
+    if (num_regions == 0) return 0;
+    region_t *grown = (region_t *)malloc(3 * (size_t)num_regions * sizeof(region_t));
+    if (!grown) return -1;
+    region_t *active = grown + num_regions;
+    region_t *merged = active + num_regions;
+
+    int num_grown = 0;
+    for (int k = 0; k < num_regions; k++) {
+        region_t g = region_expand(regions[k], halo, rows, cols);
+        if (g.r0 < g.r1 && g.c0 < g.c1) grown[num_grown++] = g;
+    }
+    // find_dirty_regions already emits this order; caller lists may not
+    qsort(grown, num_grown, sizeof(region_t), compare_regions);
+
+    long computed = 0;
+    int num_active = 0, next = 0;
+    int i = 0;
+    while (next < num_grown || num_active > 0) {
+        // Nothing covers the rows in between: skip to the next region
+        if (num_active == 0 && grown[next].r0 > i) i = grown[next].r0;
+
+        // Merge the regions starting on row i into the active list and drop
+        // the ones that ended; both inputs are sorted by column
+        int m = 0, a = 0;
+        while (a < num_active || (next < num_grown && grown[next].r0 <= i)) {
+            int take_new = next < num_grown && grown[next].r0 <= i &&
+                           (a == num_active || grown[next].c0 < active[a].c0);
+            region_t r = take_new ? grown[next++] : active[a++];
+            if (r.r1 > i) merged[m++] = r;
+        }
+        region_t *swap = active;
+        active = merged;
+        merged = swap;
+        num_active = m;
+
+        for (int k = 0; k < num_active; ) {
+            region_t run = { i, i + 1, active[k].c0, active[k].c1 };
+            for (k++; k < num_active && active[k].c0 <= run.c1; k++) {
+                if (active[k].c1 > run.c1) run.c1 = active[k].c1;
             }
-            
-            // Compute gradient magnitude
-            float magnitude = sqrtf(sum_x * sum_x + sum_y * sum_y);
-            output[i * cols + j] = magnitude;
+            filter(input, output, rows, cols, run);
+            computed += run.c1 - run.c0;
         }
+        i++;
     }
-    
-    // Handle borders - set to 0
-    for (int j = 0; j < cols; j++) {
-        output[j] = 0.0f;                          // top row
-        output[(rows - 1) * cols + j] = 0.0f;      // bottom row
+
+    free(grown);
+    return computed;
+}
+
+// Bring the state up to date with a new frame, recomputing only the changed
+// regions plus the 2-pixel halo needed by the 3x3 blur -> 3x3 Sobel chain.
+// If 'regions' is NULL the changed regions are found with a block-wise diff;
+// otherwise the caller guarantees that pixels outside them did not change.
+// Returns the number of distinct output pixels recomputed, or -1 on error.
+long incremental_update(incremental_state *st, const float *frame, const region_t *regions, int num_regions) {
+    region_t *found = NULL;
+    if (!regions) {
+        num_regions = find_dirty_regions(st->input, frame, st->rows, st->cols, &found);
+        if (num_regions < 0) return -1;
+        regions = found;
+    }
+
+    // Take the new pixels of every changed region
+    for (int k = 0; k < num_regions; k++) {
+        region_t r = region_expand(regions[k], 0, st->rows, st->cols);
+        for (int i = r.r0; i < r.r1; i++) {
+            memcpy(st->input + (size_t)i * st->cols + r.c0, frame + (size_t)i * st->cols + r.c0,
+                   (r.c1 - r.c0) * sizeof(float));
+        }
     }
-    for (int i = 0; i < rows; i++) {
-        output[i * cols] = 0.0f;                   // left column
-        output[i * cols + (cols - 1)] = 0.0f;      // right column
+
+    // All blur updates must land before any Sobel region reads them
+    long recomputed = filter_union(st->input, st->blurred, st->rows, st->cols,
+                                   regions, num_regions, 1, mean_blur_region);
+    if (recomputed >= 0) {
+        recomputed = filter_union(st->blurred, st->output, st->rows, st->cols,
+                                  regions, num_regions, 2, sobel_filter_region);
     }
+
+    free(found);
+    return recomputed;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <image_size>\n", argv[0]);
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <image_size> [next_frame.pgm ...]\n", argv[0]);
         fprintf(stderr, "Example: %s 256 or %s 4k\n", argv[0], argv[0]);
+        fprintf(stderr, "Extra frames are processed incrementally against the previous one\n");
         return 1;
     }
     
@@ -133,15 +221,16 @@ int main(int argc, char *argv[]) {
     // Build filenames: prefer 'k' format for multiples of 1000
     char input_filename[256];
     char output_filename[256];
+    char size_tag[32];
     
     if (size >= 1000 && size % 1000 == 0) {
         int k_value = size / 1000;
-        snprintf(input_filename, sizeof(input_filename), "sample_%dk.pgm", k_value);
-        snprintf(output_filename, sizeof(output_filename), "%s/sobel_%dk.pgm", OUTPUT_DIR, k_value);
+        snprintf(size_tag, sizeof(size_tag), "%dk", k_value);
     } else {
-        snprintf(input_filename, sizeof(input_filename), "sample_%d.pgm", size);
-        snprintf(output_filename, sizeof(output_filename), "%s/sobel_%d.pgm", OUTPUT_DIR, size);
+        snprintf(size_tag, sizeof(size_tag), "%d", size);
     }
+    snprintf(input_filename, sizeof(input_filename), "sample_%s.pgm", size_tag);
+    snprintf(output_filename, sizeof(output_filename), "%s/sobel_%s.pgm", OUTPUT_DIR, size_tag);
     
     // Read input image
     float *input_image = NULL;
@@ -200,10 +289,54 @@ int main(int argc, char *argv[]) {
     
     printf("Output saved successfully\n");
     
+    // Incremental mode: every extra frame only recomputes what changed
+    incremental_state state = { input_image, blurred_image, output_image, rows, cols };
+    int status = 0;
+    for (int f = 2; f < argc && status == 0; f++) {
+        float *frame = NULL;
+        int frame_rows, frame_cols;
+        
+        if (pgmread(argv[f], &frame, &frame_rows, &frame_cols) != 0) {
+            fprintf(stderr, "Error: Failed to read %s\n", argv[f]);
+            status = 1;
+            break;
+        }
+        if (frame_rows != rows || frame_cols != cols) {
+            fprintf(stderr, "Error: Frame %s is %dx%d, expected %dx%d\n",
+                    argv[f], frame_cols, frame_rows, cols, rows);
+            free(frame);
+            status = 1;
+            break;
+        }
+        
+        clock_t frame_start = clock();
+        long recomputed = incremental_update(&state, frame, NULL, 0);
+        clock_t frame_end = clock();
+        free(frame);
+        if (recomputed < 0) {
+            fprintf(stderr, "Error: Failed to allocate diff buffers\n");
+            status = 1;
+            break;
+        }
+        
+        printf("Frame %d (%s): recomputed %ld of %ld pixels (%.2f%%) in %.6f seconds\n",
+               f - 1, argv[f], recomputed, (long)rows * cols,
+               100.0 * recomputed / ((double)rows * cols),
+               (double)(frame_end - frame_start) / CLOCKS_PER_SEC);
+        
+        char frame_filename[256];
+        snprintf(frame_filename, sizeof(frame_filename), "%s/sobel_%s_f%d.pgm", OUTPUT_DIR, size_tag, f - 1);
+        if (pgmwrite(frame_filename, output_image, rows, cols, 1) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", frame_filename);
+            status = 1;
+            break;
+        }
+    }
+    
     // Cleanup
     free(input_image);
     free(blurred_image);
     free(output_image);
     
-    return 0;
+    return status;
 }
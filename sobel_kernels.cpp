@@ -0,0 +1,112 @@
+// Thin C wrappers over the sobel_kernels.hpp instantiations
+
+#include <stdlib.h>
+#include "sobel_kernels.h"
+#include "sobel_kernels.hpp"
+
+using namespace sobel;
+
+typedef MeanOp<> Blur;
+typedef GradientOp<> Gradient;
+
+extern "C" {
+
+void mean_blur(const float *input, float *output, int rows, int cols) {
+    filter3x3<Blur, BorderCopy>(input, output, rows, cols);
+}
+
+void sobel_filter(const float *input, float *output, int rows, int cols) {
+    filter3x3<Gradient, BorderZero>(input, output, rows, cols);
+}
+
+void mean_blur_region(const float *input, float *output, int rows, int cols, region_t r) {
+    filter3x3<Blur, BorderCopy>(input, output, rows, cols, r.r0, r.r1, r.c0, r.c1);
+}
+
+void sobel_filter_region(const float *input, float *output, int rows, int cols, region_t r) {
+    filter3x3<Gradient, BorderZero>(input, output, rows, cols, r.r0, r.r1, r.c0, r.c1);
+}
+
+void blur_sobel_fused(const float *input, float *output, int rows, int cols, int band_rows, int tile_cols) {
+    fused3x3<Blur, Gradient>(input, output, rows, cols, band_rows, tile_cols);
+}
+
+int blur_sobel_pyramid(const float *input, float **outputs, int levels, int rows, int cols,
+                       int band_rows, int tile_cols) {
+    float *level = NULL;
+    for (int k = 0; k < levels; k++) {
+        float *next = NULL;
+        if (k + 1 < levels) {
+            next = (float *)malloc((size_t)(rows / 2) * (cols / 2) * sizeof(float) + 1);
+            if (!next) {
+                free(level);
+                return -1;
+            }
+        }
+        fused3x3<Blur, Gradient>(k == 0 ? input : level, outputs[k], rows, cols, band_rows, tile_cols, next);
+        free(level);
+        level = next;
+        rows /= 2;
+        cols /= 2;
+    }
+    return 0;
+}
+
+int sobel_filter_oriented(const float *input, float *output, unsigned char *direction,
+                          int rows, int cols, int bins) {
+    if (bins == 4) {
+        filter3x3_oriented<Gradient, OctantQuantizer<4> >(input, output, direction, rows, cols);
+    } else if (bins == 8) {
+        filter3x3_oriented<Gradient, OctantQuantizer<8> >(input, output, direction, rows, cols);
+    } else if (bins == 256) {
+        filter3x3_oriented<Gradient, AngleQuantizer>(input, output, direction, rows, cols);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int sobel_filter_sparse(const float *input, int rows, int cols, float threshold,
+                        edge_list *edges, unsigned char *mask) {
+    edges->rows = rows;
+    edges->cols = cols;
+    edges->threshold = threshold;
+    edges->col = NULL;
+    edges->mag = NULL;
+    edges->row_ptr = (long *)malloc((rows + 1) * sizeof(long));
+    if (!edges->row_ptr) return -1;
+
+    edges->count = filter3x3_sparse<Gradient>(input, rows, cols, threshold,
+                                              edges->row_ptr, &edges->col, &edges->mag, mask);
+    if (edges->count < 0) {
+        free(edges->row_ptr);
+        edges->row_ptr = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void edge_list_free(edge_list *edges) {
+    free(edges->row_ptr);
+    free(edges->col);
+    free(edges->mag);
+    edges->row_ptr = NULL;
+    edges->col = NULL;
+    edges->mag = NULL;
+}
+
+// A strip with its ghost rows is filtered exactly like a small image:
+// the ghost rows sit on the strip frame and are never written back
+void mean_blur_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom) {
+    (void)has_top;
+    (void)has_bottom;
+    filter3x3<Blur, BorderCopy>(input, output, local_rows, cols);
+}
+
+void sobel_filter_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom) {
+    (void)has_top;
+    (void)has_bottom;
+    filter3x3<Gradient, BorderZero>(input, output, local_rows, cols);
+}
+
+} // extern "C"
@@ -0,0 +1,81 @@
+// C entry points for the 3x3 kernels (implemented in sobel_kernels.cpp)
+//
+// Build alongside any of the programs, e.g.
+//   gcc sobel.c sobel_kernels.cpp -o sobel -lstdc++ -lm
+//   gcc -fopenmp sobel_omp.c sobel_kernels.cpp -o sobel_omp -lstdc++ -lm
+//   mpicc sobel_mpi.c sobel_kernels.cpp -o sobel_mpi -lstdc++ -lm
+// With -fopenmp the kernels run multi-threaded, otherwise serially.
+
+#ifndef SOBEL_KERNELS_H
+#define SOBEL_KERNELS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Rectangle [r0, r1) x [c0, c1) in image coordinates
+typedef struct {
+    int r0, r1;
+    int c0, c1;
+} region_t;
+
+// Sparse edge pixels in CSR layout: row i owns entries [row_ptr[i], row_ptr[i+1])
+typedef struct {
+    int rows, cols;
+    float threshold;
+    long count;
+    long *row_ptr;          // rows + 1 offsets
+    int *col;               // column of each edge pixel
+    unsigned char *mag;     // magnitude, rounded and clamped like pgmwrite
+} edge_list;
+
+// Whole-image 3x3 mean blur; border pixels copy the input
+void mean_blur(const float *input, float *output, int rows, int cols);
+
+// Whole-image Sobel gradient magnitude; border pixels are 0
+void sobel_filter(const float *input, float *output, int rows, int cols);
+
+// Same as above restricted to a region (bit-identical to a full recompute)
+void mean_blur_region(const float *input, float *output, int rows, int cols, region_t r);
+void sobel_filter_region(const float *input, float *output, int rows, int cols, region_t r);
+
+// Mean blur and Sobel fused into one pass over row bands of band_rows rows,
+// optionally split into column tiles of tile_cols (<= 0: full width).
+// No blurred image is materialized; output is identical to the two passes.
+void blur_sobel_fused(const float *input, float *output, int rows, int cols, int band_rows, int tile_cols);
+
+// Fused blur + Sobel over an image pyramid. Level 0 is the input; level k+1
+// is the 2x2 mean of level k's blurred image, built from the blurred rows as
+// they stream through, so the full-resolution data is read once.
+// outputs[k] must hold (rows >> k) x (cols >> k) floats, and the smallest
+// level should be at least 3x3. Returns 0, or -1 if allocation fails.
+int blur_sobel_pyramid(const float *input, float **outputs, int levels, int rows, int cols,
+                       int band_rows, int tile_cols);
+
+// Sobel magnitude plus the quantized gradient direction from the same pass,
+// angles measured from +x (right) towards +y (down). 'bins' selects the code
+// written to 'direction' (rows x cols bytes):
+//   4    orientation modulo 180 degrees: 0, 45, 90, 135 -> 0..3
+//   8    direction in 45-degree octants -> 0..7
+//   256  angle in 256 steps per turn -> 0..255
+// Frame pixels get magnitude 0 and code 0. Returns 0, or -1 for other 'bins'.
+int sobel_filter_oriented(const float *input, float *output, unsigned char *direction,
+                          int rows, int cols, int bins);
+
+// Sobel magnitude thresholded in the same pass: only interior pixels with
+// magnitude >= threshold are kept. 'mask' (optional, zero-filled,
+// rows * ((cols + 7) / 8) bytes) receives a PBM-style bitmask.
+// Returns 0, or -1 if allocation fails.
+int sobel_filter_sparse(const float *input, int rows, int cols, float threshold,
+                        edge_list *edges, unsigned char *mask);
+void edge_list_free(edge_list *edges);
+
+// MPI strip versions: first and last local rows are ghost rows
+void mean_blur_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom);
+void sobel_filter_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOBEL_KERNELS_H
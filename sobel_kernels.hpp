@@ -0,0 +1,492 @@
+// Header-only 3x3 stencil kernels shared by the serial, OpenMP and MPI programs
+//
+// One kernel definition (filter3x3) is specialised at compile time over:
+//   - input / output pixel type (float, unsigned char)
+//   - stencil coefficients, given as constexpr arrays; zero taps are never
+//     loaded and +/-1 taps become a plain add / subtract
+//   - border policy (copy input or write 0)
+//   - for the oriented variant, the direction quantizer (octant LUT or
+//     polynomial atan2)
+//
+// Taps are accumulated in the same order as the original hand-written loops,
+// so the results are bit-identical to them. Compiled with -fopenmp the row
+// loop runs in parallel, otherwise it is serial.
+//
+// Only C++11 is required.
+
+#ifndef SOBEL_KERNELS_HPP
+#define SOBEL_KERNELS_HPP
+
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// The helpers below are tiny and called once per pixel; force them inline so
+// unoptimised (-O0) builds, as used for the benchmarks, do not pay the calls
+#if defined(__GNUC__)
+#define SOBEL_INLINE inline __attribute__((always_inline))
+#else
+#define SOBEL_INLINE inline
+#endif
+
+namespace sobel {
+
+// ---------------------------------------------------------------------------
+// Stencils: row-major 3x3 coefficients
+// ---------------------------------------------------------------------------
+
+struct MeanStencil {
+    static constexpr int weights[9] = {
+        1, 1, 1,
+        1, 1, 1,
+        1, 1, 1
+    };
+};
+
+struct SobelXStencil {
+    static constexpr int weights[9] = {
+        -1, 0, 1,
+        -2, 0, 2,
+        -1, 0, 1
+    };
+};
+
+struct SobelYStencil {
+    static constexpr int weights[9] = {
+        -1, -2, -1,
+         0,  0,  0,
+         1,  2,  1
+    };
+};
+
+// ---------------------------------------------------------------------------
+// Pixel types
+// ---------------------------------------------------------------------------
+
+template <class T> struct Pixel;
+
+template <> struct Pixel<float> {
+    static SOBEL_INLINE float load(float v) { return v; }
+    static SOBEL_INLINE float store(float v) { return v; }
+};
+
+// Same round / clamp as pgmwrite
+template <> struct Pixel<unsigned char> {
+    static SOBEL_INLINE float load(unsigned char v) { return (float)v; }
+    static SOBEL_INLINE unsigned char store(float v) {
+        int val = (int)(v + 0.5f);
+        if (val < 0) val = 0;
+        if (val > 255) val = 255;
+        return (unsigned char)val;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Taps: the 9 taps of a stencil written out flat. The weight tests are
+// constant expressions, so zero taps and the +/-1 multiplies are dropped by
+// the compiler front end itself and even an unoptimised (-O0) build gets the
+// straight-line sum of the remaining taps, with no per-tap calls.
+// ---------------------------------------------------------------------------
+
+#define SOBEL_TAP(K, v)                                                              \
+    if (S::weights[K] != 0) {                                                        \
+        acc += S::weights[K] == 1 ? (float)(v) :                                     \
+               S::weights[K] == -1 ? -(float)(v) : (float)(v) * (float)S::weights[K]; \
+    }
+
+// Sum of the taps of stencil S around 'center', in row-major order
+template <class S> struct Convolve {
+    template <class In>
+    static SOBEL_INLINE float run(const In *center, long stride) {
+        const In *up = center - stride, *down = center + stride;
+        float acc = 0.0f;
+        SOBEL_TAP(0, up[-1]) SOBEL_TAP(1, up[0]) SOBEL_TAP(2, up[1])
+        SOBEL_TAP(3, center[-1]) SOBEL_TAP(4, center[0]) SOBEL_TAP(5, center[1])
+        SOBEL_TAP(6, down[-1]) SOBEL_TAP(7, down[0]) SOBEL_TAP(8, down[1])
+        return acc;
+    }
+};
+
+// Same sum over three separate row pointers (e.g. a ring of rows), column j
+template <class S> struct ConvolveRows {
+    template <class In>
+    static SOBEL_INLINE float run(const In *const *row, int j) {
+        const In *up = row[0] + j, *mid = row[1] + j, *down = row[2] + j;
+        float acc = 0.0f;
+        SOBEL_TAP(0, up[-1]) SOBEL_TAP(1, up[0]) SOBEL_TAP(2, up[1])
+        SOBEL_TAP(3, mid[-1]) SOBEL_TAP(4, mid[0]) SOBEL_TAP(5, mid[1])
+        SOBEL_TAP(6, down[-1]) SOBEL_TAP(7, down[0]) SOBEL_TAP(8, down[1])
+        return acc;
+    }
+};
+
+#undef SOBEL_TAP
+
+// ---------------------------------------------------------------------------
+// Per-pixel operators
+// ---------------------------------------------------------------------------
+
+// Mean filter: sum of the taps scaled by 1/9
+template <class S = MeanStencil> struct MeanOp {
+    template <class In>
+    static SOBEL_INLINE float eval(const In *center, long stride) {
+        const float kernel_weight = 1.0f / 9.0f;
+        return Convolve<S>::run(center, stride) * kernel_weight;
+    }
+    template <class In>
+    static SOBEL_INLINE float eval_rows(const In *const *row, int j) {
+        const float kernel_weight = 1.0f / 9.0f;
+        return ConvolveRows<S>::run(row, j) * kernel_weight;
+    }
+};
+
+// Gradient magnitude of two stencils
+template <class SX = SobelXStencil, class SY = SobelYStencil> struct GradientOp {
+    template <class In>
+    static SOBEL_INLINE float eval(const In *center, long stride) {
+        float sum_x = Convolve<SX>::run(center, stride);
+        float sum_y = Convolve<SY>::run(center, stride);
+        return sqrtf(sum_x * sum_x + sum_y * sum_y);
+    }
+    template <class In>
+    static SOBEL_INLINE float eval_rows(const In *const *row, int j) {
+        float sum_x = ConvolveRows<SX>::run(row, j);
+        float sum_y = ConvolveRows<SY>::run(row, j);
+        return sqrtf(sum_x * sum_x + sum_y * sum_y);
+    }
+    // Magnitude as eval, plus the direction code of (sum_x, sum_y)
+    template <class Quant, class In>
+    static SOBEL_INLINE float eval_oriented(const In *center, long stride, unsigned char *code) {
+        float sum_x = Convolve<SX>::run(center, stride);
+        float sum_y = Convolve<SY>::run(center, stride);
+        *code = Quant::code(sum_x, sum_y);
+        return sqrtf(sum_x * sum_x + sum_y * sum_y);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Orientation quantizers: gradient (gx, gy) -> 8-bit direction code. Angles
+// run from +x (right) towards +y (down), as atan2(gy, gx); zero gradients
+// get code 0.
+// ---------------------------------------------------------------------------
+
+// 8 octants centred on multiples of 45 degrees (code k = k * 45 degrees), or
+// with Bins = 4 the orientation modulo 180 degrees (0, 45, 90, 135).
+// Branchless: two compares against tan(22.5) / tan(67.5) fold the angle
+// into the first quadrant, and the signs pick the unfolded code from a LUT.
+template <int Bins> struct OctantQuantizer {
+    static SOBEL_INLINE unsigned char code(float gx, float gy) {
+        static const unsigned char unfold[4][3] = {
+            { 0, 1, 2 },    // gx >= 0, gy >= 0
+            { 4, 3, 2 },    // gx <  0, gy >= 0
+            { 0, 7, 6 },    // gx >= 0, gy <  0
+            { 4, 5, 6 }     // gx <  0, gy <  0
+        };
+        float ax = fabsf(gx), ay = fabsf(gy);
+        int sector = (ay > 0.41421356f * ax) + (ay > 2.41421356f * ax);
+        int quadrant = (gx < 0.0f) | ((gy < 0.0f) << 1);
+        return (unsigned char)(unfold[quadrant][sector] & (Bins - 1));
+    }
+};
+
+// Full angle in 256 steps per turn, from a degree-9 odd minimax polynomial
+// for atan on [0, 1] (max error about 1e-5 rad, far below one step)
+struct AngleQuantizer {
+    static SOBEL_INLINE unsigned char code(float gx, float gy) {
+        float ax = fabsf(gx), ay = fabsf(gy);
+        float hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+        float z = hi > 0.0f ? lo / hi : 0.0f;
+        float z2 = z * z;
+        float a = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+        a = ay > ax ? 1.57079633f - a : a;
+        a = gx < 0.0f ? 3.14159265f - a : a;
+        a = gy < 0.0f ? 6.28318531f - a : a;
+        return (unsigned char)((int)(a * (256.0f / 6.28318531f) + 0.5f) & 255);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Border policies: what the 1-pixel frame of the image receives
+// ---------------------------------------------------------------------------
+
+struct BorderCopy {
+    template <class In, class Out>
+    static SOBEL_INLINE void apply(const In *input, Out *output, long idx) {
+        output[idx] = Pixel<Out>::store(Pixel<In>::load(input[idx]));
+    }
+};
+
+struct BorderZero {
+    template <class In, class Out>
+    static SOBEL_INLINE void apply(const In *, Out *output, long idx) {
+        output[idx] = Pixel<Out>::store(0.0f);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// The kernel
+// ---------------------------------------------------------------------------
+
+// Apply Op to the rectangle [r0, r1) x [c0, c1) of a rows x cols image.
+// Pixels on the image frame inside the rectangle get the Border policy.
+template <class Op, class Border, class In, class Out>
+void filter3x3(const In *input, Out *output, int rows, int cols,
+               int r0, int r1, int c0, int c1) {
+    int ir0 = r0 > 1 ? r0 : 1;
+    int ir1 = r1 < rows - 1 ? r1 : rows - 1;
+    int ic0 = c0 > 1 ? c0 : 1;
+    int ic1 = c1 < cols - 1 ? c1 : cols - 1;
+
+    // Interior pixels
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int i = ir0; i < ir1; i++) {
+        const In *in_row = input + (long)i * cols;
+        Out *out_row = output + (long)i * cols;
+        for (int j = ic0; j < ic1; j++) {
+            out_row[j] = Pixel<Out>::store(Op::eval(in_row + j, cols));
+        }
+    }
+
+    // Image frame
+    if (r0 == 0) {
+        for (int j = c0; j < c1; j++) Border::apply(input, output, j);
+    }
+    if (r1 == rows && rows > 1) {
+        for (int j = c0; j < c1; j++) Border::apply(input, output, (long)(rows - 1) * cols + j);
+    }
+    if (c0 == 0) {
+        for (int i = r0; i < r1; i++) Border::apply(input, output, (long)i * cols);
+    }
+    if (c1 == cols && cols > 1) {
+        for (int i = r0; i < r1; i++) Border::apply(input, output, (long)i * cols + (cols - 1));
+    }
+}
+
+// Whole-image convenience overload
+template <class Op, class Border, class In, class Out>
+void filter3x3(const In *input, Out *output, int rows, int cols) {
+    filter3x3<Op, Border>(input, output, rows, cols, 0, rows, 0, cols);
+}
+
+// Gradient Op over the whole image that also writes the direction code of
+// every pixel to 'dir' (rows x cols bytes) from the same two sums, so no
+// second stencil pass is needed. The frame gets magnitude 0 and code 0;
+// magnitudes are identical to filter3x3<Op, BorderZero>.
+template <class Op, class Quant, class In, class Out>
+void filter3x3_oriented(const In *input, Out *output, unsigned char *dir, int rows, int cols) {
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (int i = 1; i < rows - 1; i++) {
+        const In *in_row = input + (long)i * cols;
+        Out *out_row = output + (long)i * cols;
+        unsigned char *dir_row = dir + (long)i * cols;
+        for (int j = 1; j < cols - 1; j++) {
+            out_row[j] = Pixel<Out>::store(Op::template eval_oriented<Quant>(in_row + j, cols, dir_row + j));
+        }
+    }
+
+    // Image frame
+    for (int j = 0; j < cols; j++) {
+        BorderZero::apply(input, output, j);
+        dir[j] = 0;
+        if (rows > 1) {
+            BorderZero::apply(input, output, (long)(rows - 1) * cols + j);
+            dir[(long)(rows - 1) * cols + j] = 0;
+        }
+    }
+    for (int i = 0; i < rows; i++) {
+        BorderZero::apply(input, output, (long)i * cols);
+        dir[(long)i * cols] = 0;
+        if (cols > 1) {
+            BorderZero::apply(input, output, (long)i * cols + (cols - 1));
+            dir[(long)i * cols + (cols - 1)] = 0;
+        }
+    }
+}
+
+// Two chained 3x3 operators in one pass: First (with BorderCopy semantics on
+// the image frame) feeds Second (whose frame is 0). Work is split into tasks
+// of band_rows output rows x tile_cols output columns (tile_cols <= 0 means
+// full width); each task keeps a ring of three intermediate rows instead of
+// a full intermediate image, recomputing the two rows shared with its
+// neighbours. Results are identical to running the two passes separately.
+//
+// If 'down' is not NULL it also receives the 2x2 mean of the intermediate
+// image, (rows / 2) x (cols / 2), taken from the ring as rows are produced
+// (a trailing odd row / column is dropped).
+template <class First, class Second, class In, class Out>
+void fused3x3(const In *input, Out *output, int rows, int cols, int band_rows, int tile_cols,
+              float *down = NULL) {
+    int interior_rows = rows - 2, interior_cols = cols - 2;
+
+    // Frame of the output
+    for (int j = 0; j < cols; j++) {
+        output[j] = Pixel<Out>::store(0.0f);
+        if (rows > 1) output[(long)(rows - 1) * cols + j] = Pixel<Out>::store(0.0f);
+    }
+    for (int i = 0; i < rows; i++) {
+        output[(long)i * cols] = Pixel<Out>::store(0.0f);
+        if (cols > 1) output[(long)i * cols + (cols - 1)] = Pixel<Out>::store(0.0f);
+    }
+    if (interior_rows <= 0 || interior_cols <= 0) return;
+
+    if (band_rows <= 0) band_rows = interior_rows;
+    if (tile_cols <= 0 || tile_cols > interior_cols) tile_cols = interior_cols;
+    int num_bands = (interior_rows + band_rows - 1) / band_rows;
+    int num_tiles = (interior_cols + tile_cols - 1) / tile_cols;
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        std::vector<float> ring(3 * (size_t)(tile_cols + 2));
+
+#ifdef _OPENMP
+        #pragma omp for schedule(static)
+#endif
+        for (int task = 0; task < num_bands * num_tiles; task++) {
+            int i0 = 1 + (task / num_tiles) * band_rows;
+            int i1 = i0 + band_rows < rows - 1 ? i0 + band_rows : rows - 1;
+            int j0 = 1 + (task % num_tiles) * tile_cols;
+            int j1 = j0 + tile_cols < cols - 1 ? j0 + tile_cols : cols - 1;
+            int width = j1 - j0 + 2;     // intermediate columns j0-1 .. j1
+
+            // Intermediate row r goes to ring slot r % 3
+            for (int r = i0 - 1; r <= i1; r++) {
+                float *dst = &ring[(size_t)(r % 3) * (tile_cols + 2)];
+                const In *in_row = input + (long)r * cols;
+                for (int c = j0 - 1; c <= j1; c++) {
+                    if (r == 0 || r == rows - 1 || c == 0 || c == cols - 1) {
+                        dst[c - (j0 - 1)] = Pixel<In>::load(in_row[c]);
+                    } else {
+                        dst[c - (j0 - 1)] = First::eval(in_row + c, cols);
+                    }
+                }
+
+                // Odd rows complete a downsampled row; the task that owns row
+                // r also owns that row (the last task owns the bottom frame)
+                if (down && (r & 1) && r >= i0 && (r < i1 || r == rows - 1)) {
+                    const float *upper = &ring[(size_t)((r - 1) % 3) * (tile_cols + 2)];
+                    const float *lower = &ring[(size_t)(r % 3) * (tile_cols + 2)];
+                    float *down_row = down + (long)(r / 2) * (cols / 2);
+                    int q1 = j1 == cols - 1 ? cols / 2 : j1 / 2;
+                    for (int q = j0 / 2; q < q1; q++) {
+                        int x = 2 * q - (j0 - 1);
+                        down_row[q] = (upper[x] + upper[x + 1] + lower[x] + lower[x + 1]) * 0.25f;
+                    }
+                }
+
+                // Once rows r-2 .. r are ready, output row r-1 can be produced
+                int i = r - 1;
+                if (i >= i0) {
+                    const float *row[3] = {
+                        &ring[(size_t)((i - 1) % 3) * (tile_cols + 2)],
+                        &ring[(size_t)(i % 3) * (tile_cols + 2)],
+                        &ring[(size_t)((i + 1) % 3) * (tile_cols + 2)]
+                    };
+                    Out *out_row = output + (long)i * cols;
+                    for (int k = 1; k < width - 1; k++) {
+                        out_row[j0 - 1 + k] = Pixel<Out>::store(Second::eval_rows(row, k));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Apply Op to every interior pixel and keep only those whose value is
+// >= threshold, in CSR layout: row i owns entries [row_ptr[i], row_ptr[i+1])
+// of *col_out / *val_out (both malloc'd here). If mask is not NULL it
+// receives one bit per pixel, MSB first, rows padded to whole bytes (PBM).
+//
+// Each thread filters a contiguous block of rows into its own buffers; a
+// prefix sum over the per-row counts then places every block in the output.
+// Returns the number of entries, or -1 if allocation fails.
+template <class Op, class In, class Val>
+long filter3x3_sparse(const In *input, int rows, int cols, float threshold,
+                      long *row_ptr, int **col_out, Val **val_out, unsigned char *mask) {
+    long mask_stride = (cols + 7) / 8;
+    int interior = rows > 2 ? rows - 2 : 0;
+    long total = 0;
+    int failed = 0;
+    std::vector<std::vector<int> > thread_cols;
+    std::vector<std::vector<Val> > thread_vals;
+
+    *col_out = NULL;
+    *val_out = NULL;
+    for (int i = 0; i <= rows; i++) row_ptr[i] = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+        int tid = 0, nthreads = 1;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        nthreads = omp_get_num_threads();
+        #pragma omp single
+#endif
+        {
+            thread_cols.resize(nthreads);
+            thread_vals.resize(nthreads);
+        }
+
+        // Contiguous row block, so thread order is row order
+        int i0 = 1 + (int)((long)interior * tid / nthreads);
+        int i1 = 1 + (int)((long)interior * (tid + 1) / nthreads);
+        std::vector<int> &local_cols = thread_cols[tid];
+        std::vector<Val> &local_vals = thread_vals[tid];
+
+        for (int i = i0; i < i1; i++) {
+            const In *in_row = input + (long)i * cols;
+            unsigned char *mask_row = mask ? mask + i * mask_stride : NULL;
+            size_t before = local_cols.size();
+            for (int j = 1; j < cols - 1; j++) {
+                float v = Op::eval(in_row + j, cols);
+                if (v >= threshold) {
+                    local_cols.push_back(j);
+                    local_vals.push_back(Pixel<Val>::store(v));
+                    if (mask_row) mask_row[j >> 3] |= (unsigned char)(0x80 >> (j & 7));
+                }
+            }
+            row_ptr[i + 1] = (long)(local_cols.size() - before);
+        }
+
+#ifdef _OPENMP
+        #pragma omp barrier
+        #pragma omp single
+#endif
+        {
+            for (int i = 0; i < rows; i++) row_ptr[i + 1] += row_ptr[i];
+            total = row_ptr[rows];
+            *col_out = (int *)malloc((total > 0 ? total : 1) * sizeof(int));
+            *val_out = (Val *)malloc((total > 0 ? total : 1) * sizeof(Val));
+            failed = !*col_out || !*val_out;
+        }
+
+        if (!failed && !local_cols.empty()) {
+            memcpy(*col_out + row_ptr[i0], &local_cols[0], local_cols.size() * sizeof(int));
+            memcpy(*val_out + row_ptr[i0], &local_vals[0], local_vals.size() * sizeof(Val));
+        }
+    }
+
+    if (failed) {
+        free(*col_out);
+        free(*val_out);
+        *col_out = NULL;
+        *val_out = NULL;
+        return -1;
+    }
+    return total;
+}
+
+} // namespace sobel
+
+#endif // SOBEL_KERNELS_HPP
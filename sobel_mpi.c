@@ -6,121 +6,496 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "pgmio.h"
+#include "sobel_kernels.h"
 
 #define OUTPUT_DIR "output"
 
-// Apply 3x3 mean blur filter on local image chunk with ghost rows
-void mean_blur_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom) {
-    const float kernel_weight = 1.0f / 9.0f;
-    
-    // Determine processing range (skip boundaries that need ghost rows)
-    int start_row = has_top ? 1 : 1;  // Always skip first row if it's a boundary
-    int end_row = has_bottom ? local_rows - 1 : local_rows - 1;  // Always skip last row
-    
-    // Process interior pixels
-    for (int i = start_row; i < end_row; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum = 0.0f;
+// Partitioning modes
+enum { MODE_STATIC, MODE_BALANCED, MODE_SHARED };
+static const char *mode_names[] = { "static", "balanced", "shm" };
+
+// Input rows [lo, hi) needed to produce output rows [b0, b1): the blur and the
+// Sobel each need one ghost row, so two on each side (clamped to the image)
+static void band_halo(int b0, int b1, int rows, int *lo, int *hi) {
+    *lo = b0 - 2 < 0 ? 0 : b0 - 2;
+    *hi = b1 + 2 > rows ? rows : b1 + 2;
+}
+
+// Filter one band. 'strip' holds input rows [lo, hi); the rows that are not on
+// the strip frame come out identical to a full-image run.
+static void filter_band(const float *strip, float *blurred, float *output, int lo, int hi, int cols) {
+    mean_blur_local(strip, blurred, hi - lo, cols, 1, 1);
+    sobel_filter_local(blurred, output, hi - lo, cols, 1, 1);
+}
+
+// Static mode: fixed rows / num_procs strips, each with the two ghost rows
+// per side that the blur -> Sobel chain needs
+static void run_static(int rank, int num_procs, const float *full_image, float *full_output,
+                       int rows, int cols, double *elapsed, double *busy, double *idle) {
+    // Calculate rows per process
+    int rows_per_proc = rows / num_procs;
+    int remainder = rows % num_procs;
+    
+    // Calculate this process's row range
+    int local_rows_actual;
+    if (rank < remainder) {
+        local_rows_actual = rows_per_proc + 1;
+    } else {
+        local_rows_actual = rows_per_proc;
+    }
+    int first_row = rank * rows_per_proc + (rank < remainder ? rank : remainder);
+    
+    // Add ghost rows (clamped at the first and last process boundaries)
+    int lo, hi;
+    band_halo(first_row, first_row + local_rows_actual, rows, &lo, &hi);
+    int top_ghost = first_row - lo;
+    int local_rows_with_ghost = hi - lo;
+    
+    // Allocate local buffers
+    size_t buffer_size = (size_t)local_rows_with_ghost * cols * sizeof(float);
+    float *local_image = (float *)malloc(buffer_size);
+    float *local_blurred = (float *)malloc(buffer_size);
+    float *local_output = (float *)malloc(buffer_size);
+    
+    if (!local_image || !local_blurred || !local_output) {
+        fprintf(stderr, "Rank %d: Failed to allocate %zu bytes\n", rank, buffer_size);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    
+    // Initialize buffers to zero
+    memset(local_image, 0, buffer_size);
+    memset(local_blurred, 0, buffer_size);
+    memset(local_output, 0, buffer_size);
+    
+    // Distribute image data
+    if (rank == 0) {
+        // Root process: copy its own portion (it has no top ghost rows)
+        memcpy(local_image, full_image, buffer_size);
+        
+        // Send to other processes, including their ghost rows
+        int current_row = local_rows_actual;
+        for (int p = 1; p < num_procs; p++) {
+            int p_rows_actual = (p < remainder) ? rows_per_proc + 1 : rows_per_proc;
+            int p_lo, p_hi;
+            band_halo(current_row, current_row + p_rows_actual, rows, &p_lo, &p_hi);
             
-            // Apply 3x3 convolution
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    sum += input[(i + ki) * cols + (j + kj)];
-                }
-            }
+            MPI_Send(full_image + (size_t)p_lo * cols, 
+                    (p_hi - p_lo) * cols, 
+                    MPI_FLOAT, p, 0, MPI_COMM_WORLD);
+            
+            current_row += p_rows_actual;
+        }
+    } else {
+        // Receive data
+        MPI_Recv(local_image, local_rows_with_ghost * cols, 
+                MPI_FLOAT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+    
+    // Synchronize before timing
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    
+    // Apply mean blur and Sobel filter locally
+    filter_band(local_image, local_blurred, local_output, lo, hi, cols);
+    double finish_time = MPI_Wtime();
+    *busy = finish_time - start_time;
+    
+    // Synchronize after computation
+    MPI_Barrier(MPI_COMM_WORLD);
+    *elapsed = MPI_Wtime() - start_time;
+    *idle = MPI_Wtime() - finish_time;
+    
+    // Gather results back to root (without ghost rows)
+    int src_offset = top_ghost * cols;
+    if (rank == 0) {
+        memcpy(full_output, local_output + src_offset, (size_t)local_rows_actual * cols * sizeof(float));
+        
+        // Receive from other processes
+        int current_row = local_rows_actual;
+        for (int p = 1; p < num_procs; p++) {
+            int p_rows_actual = (p < remainder) ? rows_per_proc + 1 : rows_per_proc;
+            
+            MPI_Recv(full_output + (size_t)current_row * cols, 
+                    p_rows_actual * cols, 
+                    MPI_FLOAT, p, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
             
-            output[i * cols + j] = sum * kernel_weight;
+            current_row += p_rows_actual;
         }
+    } else {
+        MPI_Send(local_output + src_offset, 
+                local_rows_actual * cols, 
+                MPI_FLOAT, 0, 1, MPI_COMM_WORLD);
+    }
+    
+    free(local_image);
+    free(local_blurred);
+    free(local_output);
+}
+
+// Message tags for the balanced-mode work queue
+#define TAG_REQUEST 10
+#define TAG_ASSIGN  11
+#define TAG_RESULT  12
+
+// Default smallest row band handed out in balanced mode
+#define MIN_BAND_ROWS 16
+
+// Guided schedule: large bands first, shrinking towards min_band as work runs out
+static int next_band_rows(int remaining, int num_procs, int min_band) {
+    int band = remaining / (2 * num_procs);
+    if (band < min_band) band = min_band;
+    if (band > remaining) band = remaining;
+    return band;
+}
+
+// Grow a scratch buffer to hold at least 'count' floats
+static float *ensure_capacity(float *buf, size_t *capacity, size_t count, int rank) {
+    if (count <= *capacity) return buf;
+    buf = (float *)realloc(buf, count * sizeof(float));
+    if (!buf) {
+        fprintf(stderr, "Rank %d: Failed to allocate %zu bytes\n", rank, count * sizeof(float));
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
+    *capacity = count;
+    return buf;
+}
+
+// Balanced mode: rank 0 keeps a queue of row bands and hands the next one to
+// whichever rank finishes first, so faster or less loaded ranks take more
+// rows. Rank 0 works on small bands itself while no request is pending.
+//
+// To be timed on the same basis as static mode, the image goes out before the
+// clock starts (one copy per node in a shared window) and the results come
+// back after the closing barrier; only the 2-int band messages are timed.
+static void run_balanced(int rank, int num_procs, const float *full_image, float *full_output,
+                         int rows, int cols, int min_band, double *elapsed, double *busy, double *idle,
+                         int *rows_done) {
+    MPI_Comm node_comm, leader_comm;
+    int node_rank;
+    
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+    
+    // Node leader allocates the input image; the others map it
+    size_t plane = (size_t)rows * cols;
+    float *image = NULL;
+    MPI_Win win;
+    MPI_Aint win_size = node_rank == 0 ? (MPI_Aint)(plane * sizeof(float)) : 0;
+    MPI_Win_allocate_shared(win_size, sizeof(float), MPI_INFO_NULL, node_comm, &image, &win);
+    if (node_rank != 0) {
+        MPI_Aint qsize;
+        int qdisp;
+        MPI_Win_shared_query(win, 0, &qsize, &qdisp, &image);
+    }
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
     
-    // Handle borders: copy from input
-    // Left and right columns
-    for (int i = 0; i < local_rows; i++) {
-        output[i * cols] = input[i * cols];
-        output[i * cols + (cols - 1)] = input[i * cols + (cols - 1)];
+    if (node_rank == 0) {
+        if (rank == 0) memcpy(image, full_image, plane * sizeof(float));
+        MPI_Bcast(image, (int)plane, MPI_FLOAT, 0, leader_comm);
+        MPI_Comm_free(&leader_comm);
     }
+    MPI_Win_sync(win);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(win);
+    
+    float *blurred = NULL, *output = NULL, *done = NULL;
+    size_t blurred_cap = 0, output_cap = 0, done_cap = 0;
+    int *done_bands = NULL;
+    int num_done = 0, done_bands_cap = 0;
+    size_t done_count = 0;
+    int band[2] = { -1, -1 };
+    int lo = 0, hi = 0;
+    
+    *busy = 0.0;
+    *rows_done = 0;
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
     
-    // Top row
-    if (!has_top) {
-        for (int j = 0; j < cols; j++) {
-            output[j] = input[j];
+    if (rank == 0) {
+        int next_row = 0;
+        int active = num_procs - 1;
+        
+        while (active > 0 || next_row < rows) {
+            int pending = 0;
+            MPI_Status status;
+            
+            if (active > 0) {
+                if (next_row < rows) {
+                    MPI_Iprobe(MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &pending, &status);
+                } else {
+                    // Nothing left to compute: just wait for the stragglers
+                    MPI_Probe(MPI_ANY_SOURCE, TAG_REQUEST, MPI_COMM_WORLD, &status);
+                    pending = 1;
+                }
+            }
+            
+            if (pending) {
+                int src = status.MPI_SOURCE;
+                MPI_Recv(band, 2, MPI_INT, src, TAG_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                
+                // Hand out the next band, or tell the rank to stop
+                if (next_row < rows) {
+                    band[0] = next_row;
+                    band[1] = next_row + next_band_rows(rows - next_row, num_procs, min_band);
+                    next_row = band[1];
+                } else {
+                    band[0] = band[1] = -1;
+                    active--;
+                }
+                MPI_Send(band, 2, MPI_INT, src, TAG_ASSIGN, MPI_COMM_WORLD);
+            } else if (next_row < rows) {
+                // Root takes a minimum-size band so it stays responsive
+                int b0 = next_row;
+                int b1 = b0 + min_band > rows ? rows : b0 + min_band;
+                next_row = b1;
+                band_halo(b0, b1, rows, &lo, &hi);
+                
+                size_t count = (size_t)(hi - lo) * cols;
+                blurred = ensure_capacity(blurred, &blurred_cap, count, rank);
+                output = ensure_capacity(output, &output_cap, count, rank);
+                
+                double t0 = MPI_Wtime();
+                filter_band(image + (size_t)lo * cols, blurred, output, lo, hi, cols);
+                *busy += MPI_Wtime() - t0;
+                *rows_done += b1 - b0;
+                
+                memcpy(full_output + (size_t)b0 * cols, output + (size_t)(b0 - lo) * cols,
+                       (size_t)(b1 - b0) * cols * sizeof(float));
+            }
         }
     } else {
-        // Copy ghost row
-        for (int j = 0; j < cols; j++) {
-            output[j] = input[j];
+        for (;;) {
+            MPI_Send(band, 2, MPI_INT, 0, TAG_REQUEST, MPI_COMM_WORLD);
+            MPI_Recv(band, 2, MPI_INT, 0, TAG_ASSIGN, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (band[0] < 0) break;
+            
+            band_halo(band[0], band[1], rows, &lo, &hi);
+            size_t count = (size_t)(hi - lo) * cols;
+            size_t band_count = (size_t)(band[1] - band[0]) * cols;
+            blurred = ensure_capacity(blurred, &blurred_cap, count, rank);
+            output = ensure_capacity(output, &output_cap, count, rank);
+            done = ensure_capacity(done, &done_cap, done_count + band_count, rank);
+            
+            double t0 = MPI_Wtime();
+            filter_band(image + (size_t)lo * cols, blurred, output, lo, hi, cols);
+            *busy += MPI_Wtime() - t0;
+            *rows_done += band[1] - band[0];
+            
+            // Keep the finished rows until the timed phase is over
+            memcpy(done + done_count, output + (size_t)(band[0] - lo) * cols, band_count * sizeof(float));
+            done_count += band_count;
+            if (num_done == done_bands_cap) {
+                done_bands_cap = done_bands_cap ? 2 * done_bands_cap : 16;
+                done_bands = (int *)realloc(done_bands, 2 * done_bands_cap * sizeof(int));
+                if (!done_bands) {
+                    fprintf(stderr, "Rank %d: Failed to allocate band list\n", rank);
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+            }
+            done_bands[2 * num_done] = band[0];
+            done_bands[2 * num_done + 1] = band[1];
+            num_done++;
         }
     }
+    double finish_time = MPI_Wtime();
     
-    // Bottom row
-    if (!has_bottom) {
-        for (int j = 0; j < cols; j++) {
-            output[(local_rows - 1) * cols + j] = input[(local_rows - 1) * cols + j];
+    MPI_Barrier(MPI_COMM_WORLD);
+    *elapsed = MPI_Wtime() - start_time;
+    *idle = MPI_Wtime() - finish_time;
+    
+    // Collect the workers' bands
+    if (rank == 0) {
+        for (int p = 1; p < num_procs; p++) {
+            int count;
+            MPI_Recv(&count, 1, MPI_INT, p, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            for (int b = 0; b < count; b++) {
+                MPI_Recv(band, 2, MPI_INT, p, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Recv(full_output + (size_t)band[0] * cols, (band[1] - band[0]) * cols,
+                         MPI_FLOAT, p, TAG_RESULT, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            }
         }
     } else {
-        // Copy ghost row
-        for (int j = 0; j < cols; j++) {
-            output[(local_rows - 1) * cols + j] = input[(local_rows - 1) * cols + j];
+        MPI_Send(&num_done, 1, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+        size_t offset = 0;
+        for (int b = 0; b < num_done; b++) {
+            int *db = done_bands + 2 * b;
+            MPI_Send(db, 2, MPI_INT, 0, TAG_RESULT, MPI_COMM_WORLD);
+            MPI_Send(done + offset, (db[1] - db[0]) * cols, MPI_FLOAT, 0, TAG_RESULT, MPI_COMM_WORLD);
+            offset += (size_t)(db[1] - db[0]) * cols;
         }
     }
+    
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+    MPI_Comm_free(&node_comm);
+    free(done_bands);
+    free(done);
+    free(blurred);
+    free(output);
 }
 
-// Apply Sobel operator on local image chunk with ghost rows
-void sobel_filter_local(const float *input, float *output, int local_rows, int cols, int has_top, int has_bottom) {
-    // Sobel kernels
-    int Gx[3][3] = {
-        {-1, 0, 1},
-        {-2, 0, 2},
-        {-1, 0, 1}
-    };
-    
-    int Gy[3][3] = {
-        {-1, -2, -1},
-        { 0,  0,  0},
-        { 1,  2,  1}
-    };
-    
-    // Determine processing range
-    int start_row = has_top ? 1 : 1;
-    int end_row = has_bottom ? local_rows - 1 : local_rows - 1;
-    
-    // Process interior pixels
-    for (int i = start_row; i < end_row; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum_x = 0.0f;
-            float sum_y = 0.0f;
-            
-            // Apply 3x3 convolution
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    float pixel = input[(i + ki) * cols + (j + kj)];
-                    sum_x += pixel * Gx[ki + 1][kj + 1];
-                    sum_y += pixel * Gy[ki + 1][kj + 1];
-                }
+// Output rows [*r0, *r1) of rank p under the static rows / num_procs split
+static void static_rows(int p, int num_procs, int rows, int *r0, int *r1) {
+    int rows_per_proc = rows / num_procs;
+    int remainder = rows % num_procs;
+    *r0 = p * rows_per_proc + (p < remainder ? p : remainder);
+    *r1 = *r0 + rows_per_proc + (p < remainder ? 1 : 0);
+}
+
+// Shared-memory mode: ranks on the same node share one MPI-3 window holding
+// the node's input, blurred and output rows, so neighbour rows are read in
+// place instead of being exchanged as ghost-row messages. Only one leader per
+// node talks to rank 0 across the network.
+static void run_shared(int rank, int num_procs, const float *full_image, float *full_output,
+                       int rows, int cols, double *elapsed, double *busy, double *idle) {
+    MPI_Comm node_comm, leader_comm;
+    int node_rank, node_size;
+    
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+    
+    // World ranks living on this node
+    int *node_members = (int *)malloc(node_size * sizeof(int));
+    MPI_Allgather(&rank, 1, MPI_INT, node_members, 1, MPI_INT, node_comm);
+    
+    // Rows owned by this rank, and the node's input span including the
+    // two halo rows needed by the blur -> Sobel chain
+    int r0, r1;
+    static_rows(rank, num_procs, rows, &r0, &r1);
+    
+    int span[2] = { r0 < r1 ? r0 : rows, r0 < r1 ? -r1 : 0 };
+    MPI_Allreduce(MPI_IN_PLACE, span, 2, MPI_INT, MPI_MIN, node_comm);
+    int in_lo = span[0] - 2 < 0 ? 0 : span[0] - 2;
+    int in_hi = -span[1] + 2 > rows ? rows : -span[1] + 2;
+    int span_rows = in_hi > in_lo ? in_hi - in_lo : 0;
+    size_t plane = (size_t)span_rows * cols;
+    
+    // Node leader allocates the whole window; the others map it
+    float *win_base = NULL;
+    MPI_Win win;
+    MPI_Aint win_size = node_rank == 0 ? (MPI_Aint)(3 * plane * sizeof(float)) : 0;
+    MPI_Win_allocate_shared(win_size, sizeof(float), MPI_INFO_NULL, node_comm, &win_base, &win);
+    if (node_rank != 0) {
+        MPI_Aint qsize;
+        int qdisp;
+        MPI_Win_shared_query(win, 0, &qsize, &qdisp, &win_base);
+    }
+    float *win_in = win_base;
+    float *win_blurred = win_base + plane;
+    float *win_out = win_base + 2 * plane;
+    
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+    
+    // Leaders receive the node's input span from rank 0
+    if (node_rank == 0) {
+        int leader_rank, num_leaders;
+        MPI_Comm_rank(leader_comm, &leader_rank);
+        MPI_Comm_size(leader_comm, &num_leaders);
+        
+        int my_span[2] = { in_lo, in_hi };
+        int *all_spans = NULL;
+        if (leader_rank == 0) {
+            all_spans = (int *)malloc(2 * num_leaders * sizeof(int));
+        }
+        MPI_Gather(my_span, 2, MPI_INT, all_spans, 2, MPI_INT, 0, leader_comm);
+        
+        if (leader_rank == 0) {
+            memcpy(win_in, full_image + (size_t)in_lo * cols, plane * sizeof(float));
+            for (int l = 1; l < num_leaders; l++) {
+                int lo = all_spans[2 * l], hi = all_spans[2 * l + 1];
+                MPI_Send(full_image + (size_t)lo * cols, (hi - lo) * cols,
+                         MPI_FLOAT, l, 0, leader_comm);
             }
-            
-            // Compute gradient magnitude
-            float magnitude = sqrtf(sum_x * sum_x + sum_y * sum_y);
-            output[i * cols + j] = magnitude;
+            free(all_spans);
+        } else {
+            MPI_Recv(win_in, (int)plane, MPI_FLOAT, 0, 0, leader_comm, MPI_STATUS_IGNORE);
         }
     }
+    MPI_Win_sync(win);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(win);
+    
+    // A rank also blurs the halo row next to a neighbour that is off-node,
+    // since nobody on this node would produce it otherwise
+    int is_on_node_prev = 0, is_on_node_next = 0;
+    for (int k = 0; k < node_size; k++) {
+        if (node_members[k] == rank - 1) is_on_node_prev = 1;
+        if (node_members[k] == rank + 1) is_on_node_next = 1;
+    }
+    int b0 = r0, b1 = r1;
+    if (r0 < r1) {
+        if (!is_on_node_prev && b0 > 0) b0--;
+        if (!is_on_node_next && b1 < rows) b1++;
+    }
+    
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
     
-    // Handle borders: set to 0
-    // Left and right columns
-    for (int i = 0; i < local_rows; i++) {
-        output[i * cols] = 0.0f;
-        output[i * cols + (cols - 1)] = 0.0f;
+    // Window rows are addressed relative to in_lo; the window's first and last
+    // rows only fall on the strip frame when they are also the image frame
+    if (b0 < b1) {
+        region_t blur_rows = { b0 - in_lo, b1 - in_lo, 0, cols };
+        mean_blur_region(win_in, win_blurred, span_rows, cols, blur_rows);
     }
     
-    // Top row
-    for (int j = 0; j < cols; j++) {
-        output[j] = 0.0f;
+    // Neighbours' blurred rows must be visible before the Sobel pass
+    MPI_Win_sync(win);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(win);
+    
+    if (r0 < r1) {
+        region_t sobel_rows = { r0 - in_lo, r1 - in_lo, 0, cols };
+        sobel_filter_region(win_blurred, win_out, span_rows, cols, sobel_rows);
     }
+    double finish_time = MPI_Wtime();
+    *busy = finish_time - start_time;
+    
+    MPI_Win_sync(win);
+    MPI_Barrier(MPI_COMM_WORLD);
+    *elapsed = MPI_Wtime() - start_time;
+    *idle = MPI_Wtime() - finish_time;
     
-    // Bottom row
-    for (int j = 0; j < cols; j++) {
-        output[(local_rows - 1) * cols + j] = 0.0f;
+    // Leaders send every on-node rank's rows to rank 0, tagged with that rank
+    if (node_rank == 0) {
+        int leader_rank;
+        MPI_Comm_rank(leader_comm, &leader_rank);
+        
+        if (leader_rank == 0) {
+            for (int p = 0; p < num_procs; p++) {
+                int p0, p1, local = 0;
+                static_rows(p, num_procs, rows, &p0, &p1);
+                for (int k = 0; k < node_size; k++) {
+                    if (node_members[k] == p) local = 1;
+                }
+                if (p1 <= p0) continue;
+                if (local) {
+                    memcpy(full_output + (size_t)p0 * cols, win_out + (size_t)(p0 - in_lo) * cols,
+                           (size_t)(p1 - p0) * cols * sizeof(float));
+                } else {
+                    MPI_Recv(full_output + (size_t)p0 * cols, (p1 - p0) * cols, MPI_FLOAT,
+                             MPI_ANY_SOURCE, p, leader_comm, MPI_STATUS_IGNORE);
+                }
+            }
+        } else {
+            for (int k = 0; k < node_size; k++) {
+                int p0, p1;
+                static_rows(node_members[k], num_procs, rows, &p0, &p1);
+                if (p1 <= p0) continue;
+                MPI_Send(win_out + (size_t)(p0 - in_lo) * cols, (p1 - p0) * cols, MPI_FLOAT,
+                         0, node_members[k], leader_comm);
+            }
+        }
+        MPI_Comm_free(&leader_comm);
     }
+    
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+    MPI_Comm_free(&node_comm);
+    free(node_members);
 }
 
 int main(int argc, char *argv[]) {
@@ -130,10 +505,10 @@ int main(int argc, char *argv[]) {
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
     
-    if (argc != 2) {
+    if (argc < 2 || argc > 4) {
         if (rank == 0) {
-            fprintf(stderr, "Usage: %s <image_size>\n", argv[0]);
-            fprintf(stderr, "Example: %s 256 or %s 4k\n", argv[0], argv[0]);
+            fprintf(stderr, "Usage: %s <image_size> [static|balanced|shm] [min_band_rows]\n", argv[0]);
+            fprintf(stderr, "Example: %s 256 or %s 4k balanced\n", argv[0], argv[0]);
         }
         MPI_Finalize();
         return 1;
@@ -163,6 +538,33 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Parse partitioning mode
+    int mode = MODE_STATIC;
+    int min_band = MIN_BAND_ROWS;
+    if (argc >= 3) {
+        if (strcmp(argv[2], "balanced") == 0) {
+            mode = MODE_BALANCED;
+        } else if (strcmp(argv[2], "shm") == 0) {
+            mode = MODE_SHARED;
+        } else if (strcmp(argv[2], "static") != 0) {
+            if (rank == 0) {
+                fprintf(stderr, "Error: Unknown mode '%s' (expected static, balanced or shm)\n", argv[2]);
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    if (argc >= 4) {
+        min_band = atoi(argv[3]);
+        if (min_band <= 0) {
+            if (rank == 0) {
+                fprintf(stderr, "Error: Invalid band size\n");
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    
     // Variables for image data
     float *full_image = NULL;
     float *full_output = NULL;
@@ -198,114 +600,31 @@ int main(int argc, char *argv[]) {
     MPI_Bcast(&rows, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&cols, 1, MPI_INT, 0, MPI_COMM_WORLD);
     
-    // Calculate rows per process
-    int rows_per_proc = rows / num_procs;
-    int remainder = rows % num_procs;
     
-    // Calculate this process's row range
-    int start_row, local_rows_actual;
-    if (rank < remainder) {
-        local_rows_actual = rows_per_proc + 1;
-        start_row = rank * local_rows_actual;
+    // Filter the image with the chosen partitioning
+    double elapsed, busy, idle;
+    int r0, r1;
+    static_rows(rank, num_procs, rows, &r0, &r1);
+    int rows_done = r1 - r0;
+    if (mode == MODE_BALANCED) {
+        run_balanced(rank, num_procs, full_image, full_output, rows, cols, min_band,
+                     &elapsed, &busy, &idle, &rows_done);
+    } else if (mode == MODE_SHARED) {
+        run_shared(rank, num_procs, full_image, full_output, rows, cols, &elapsed, &busy, &idle);
     } else {
-        local_rows_actual = rows_per_proc;
-        start_row = rank * rows_per_proc + remainder;
-    }
-    
-    // Add ghost rows (except for first and last process boundaries)
-    int has_top_ghost = (rank > 0) ? 1 : 0;
-    int has_bottom_ghost = (rank < num_procs - 1) ? 1 : 0;
-    int local_rows_with_ghost = local_rows_actual + has_top_ghost + has_bottom_ghost;
-    
-    // Allocate local buffers
-    size_t buffer_size = local_rows_with_ghost * cols * sizeof(float);
-    float *local_image = (float *)malloc(buffer_size);
-    float *local_blurred = (float *)malloc(buffer_size);
-    float *local_output = (float *)malloc(buffer_size);
-    
-    if (!local_image || !local_blurred || !local_output) {
-        fprintf(stderr, "Rank %d: Failed to allocate %zu bytes\n", rank, buffer_size);
-        MPI_Abort(MPI_COMM_WORLD, 1);
+        run_static(rank, num_procs, full_image, full_output, rows, cols, &elapsed, &busy, &idle);
     }
     
-    // Initialize buffers to zero
-    memset(local_image, 0, buffer_size);
-    memset(local_blurred, 0, buffer_size);
-    memset(local_output, 0, buffer_size);
-    
-    // Distribute image data
+    // Compute time, idle time and rows of every rank, to report load imbalance
+    double times[3] = { busy, idle, (double)rows_done };
+    double *all_times = NULL;
     if (rank == 0) {
-        // Root process: copy its own portion (without ghost rows since it's the first)
-        int dst_offset = has_top_ghost ? cols : 0;
-        size_t copy_size = local_rows_actual * cols * sizeof(float);
-        memcpy(local_image + dst_offset, full_image, copy_size);
-        
-        // Send to other processes
-        int current_row = local_rows_actual;
-        for (int p = 1; p < num_procs; p++) {
-            int p_rows_actual = (p < remainder) ? rows_per_proc + 1 : rows_per_proc;
-            int p_has_top = 1;
-            int p_has_bottom = (p < num_procs - 1) ? 1 : 0;
-            
-            // Send starting from one row before (for ghost row)
-            int send_start_row = current_row - p_has_top;
-            int send_row_count = p_rows_actual + p_has_top + p_has_bottom;
-            
-            MPI_Send(full_image + send_start_row * cols, 
-                    send_row_count * cols, 
-                    MPI_FLOAT, p, 0, MPI_COMM_WORLD);
-            
-            current_row += p_rows_actual;
-        }
-    } else {
-        // Receive data
-        MPI_Recv(local_image, local_rows_with_ghost * cols, 
-                MPI_FLOAT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-    }
-    
-    // Synchronize before timing
-    MPI_Barrier(MPI_COMM_WORLD);
-    double start_time = MPI_Wtime();
-    
-    // Apply mean blur filter locally
-    mean_blur_local(local_image, local_blurred, local_rows_with_ghost, cols, has_top_ghost, has_bottom_ghost);
-    
-    // Apply Sobel filter locally
-    sobel_filter_local(local_blurred, local_output, local_rows_with_ghost, cols, has_top_ghost, has_bottom_ghost);
-    
-    // Synchronize after computation
-    MPI_Barrier(MPI_COMM_WORLD);
-    double end_time = MPI_Wtime();
-    
-    // Gather results back to root
-    if (rank == 0) {
-        // Copy root's portion (skip ghost rows if any)
-        int src_offset = has_top_ghost ? cols : 0;
-        memcpy(full_output, local_output + src_offset, local_rows_actual * cols * sizeof(float));
-        
-        // Receive from other processes
-        int current_row = local_rows_actual;
-        for (int p = 1; p < num_procs; p++) {
-            int p_rows_actual = (p < remainder) ? rows_per_proc + 1 : rows_per_proc;
-            
-            MPI_Recv(full_output + current_row * cols, 
-                    p_rows_actual * cols, 
-                    MPI_FLOAT, p, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            
-            current_row += p_rows_actual;
-        }
-    } else {
-        // Send result (without ghost rows)
-        int src_offset = has_top_ghost ? cols : 0;
-        MPI_Send(local_output + src_offset, 
-                local_rows_actual * cols, 
-                MPI_FLOAT, 0, 1, MPI_COMM_WORLD);
+        all_times = (double *)malloc(3 * num_procs * sizeof(double));
     }
+    MPI_Gather(times, 3, MPI_DOUBLE, all_times, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
     
     // Root process writes output and prints timing
     if (rank == 0) {
-        double elapsed = end_time - start_time;
-        
         // Collect node information from all processes
         char *all_names = (char *)malloc(num_procs * MPI_MAX_PROCESSOR_NAME * sizeof(char));
         char processor_name[MPI_MAX_PROCESSOR_NAME];
@@ -335,6 +654,50 @@ int main(int argc, char *argv[]) {
         
         free(all_names);
         
+        // Imbalance = slowest rank's compute time over the mean; 1.0 is
+        // perfect. Idle = time from a rank's last row to the closing barrier.
+        // Rank 0 mostly coordinates in balanced mode, so with more than one
+        // process every mode compares ranks 1..N-1 only, and the figures of
+        // different modes can be compared directly.
+        int first = num_procs > 1 ? 1 : 0;
+        int num_ranks = num_procs - first;
+        double busy_max = 0.0, busy_sum = 0.0, idle_max = 0.0, idle_sum = 0.0;
+        for (int p = first; p < num_procs; p++) {
+            double p_busy = all_times[3 * p], p_idle = all_times[3 * p + 1];
+            if (p_busy > busy_max) busy_max = p_busy;
+            if (p_idle > idle_max) idle_max = p_idle;
+            busy_sum += p_busy;
+            idle_sum += p_idle;
+        }
+        double busy_mean = busy_sum / num_ranks;
+        printf("Mode: %s | Ranks: %d-%d | Compute max: %.6f | Compute mean: %.6f | Imbalance (max/mean): %.3f"
+               " | Idle max: %.6f | Idle mean: %.6f\n",
+               mode_names[mode], first, num_procs - 1, busy_max, busy_mean,
+               busy_mean > 0.0 ? busy_max / busy_mean : 1.0, idle_max, idle_sum / num_ranks);
+        
+        // What a static rows / num_procs split would have cost on the same
+        // ranks: each rank's measured rows per second applied to its static
+        // share. Ranks that computed no rows have no rate and are skipped.
+        if (mode == MODE_BALANCED) {
+            double est_max = 0.0, est_sum = 0.0;
+            int est_ranks = 0;
+            for (int p = first; p < num_procs; p++) {
+                double p_busy = all_times[3 * p], p_rows = all_times[3 * p + 2];
+                if (p_rows <= 0.0 || p_busy <= 0.0) continue;
+                int s0, s1;
+                static_rows(p, num_procs, rows, &s0, &s1);
+                double est = (s1 - s0) * p_busy / p_rows;
+                if (est > est_max) est_max = est;
+                est_sum += est;
+                est_ranks++;
+            }
+            double est_mean = est_ranks > 0 ? est_sum / est_ranks : 0.0;
+            printf("Static split estimate | Ranks measured: %d | Compute max: %.6f | Compute mean: %.6f"
+                   " | Imbalance (max/mean): %.3f\n",
+                   est_ranks, est_max, est_mean, est_mean > 0.0 ? est_max / est_mean : 1.0);
+        }
+        free(all_times);
+        
         // Build output filename
         char output_filename[256];
         if (size >= 1000 && size % 1000 == 0) {
@@ -360,11 +723,6 @@ int main(int argc, char *argv[]) {
                    NULL, 0, MPI_CHAR, 0, MPI_COMM_WORLD);
     }
     
-    // Cleanup
-    free(local_image);
-    free(local_blurred);
-    free(local_output);
-    
     MPI_Finalize();
     return 0;
 }
@@ -6,119 +6,296 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "pgmio.h"
+#include "sobel_kernels.h"
+#include "tileio.h"
+#include "edgeio.h"
+#include "planner.h"
 
 #define OUTPUT_DIR "output"
 
-// Apply 3x3 mean blur filter using OpenMP parallelization
-void mean_blur(const float *input, float *output, int rows, int cols) {
-    const float kernel_weight = 1.0f / 9.0f;
-    
-    // Parallelize the main computation loop
-    // Each thread processes different rows independently
-    #pragma omp parallel for schedule(static)
-    for (int i = 1; i < rows - 1; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum = 0.0f;
-            
-            // Apply 3x3 convolution
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    sum += input[(i + ki) * cols + (j + kj)];
-                }
-            }
-            
-            output[i * cols + j] = sum * kernel_weight;
-        }
+// Most levels --pyramid can produce
+#define PYRAMID_MAX_LEVELS 16
+
+// Tiled mode: read only the input tiles under the requested region plus its
+// 2-pixel halo, filter that window, and write each output tile independently.
+// The region is widened to whole output tiles. h or w <= 0 means the full image.
+static int run_tiled(const char *input_filename, const char *output_filename,
+                     int r0, int c0, int h, int w) {
+    tiled_image in;
+    if (tileio_open(input_filename, &in) != 0) {
+        fprintf(stderr, "Error: Failed to open %s\n", input_filename);
+        return -1;
     }
+    int rows = in.rows, cols = in.cols;
+    int th = in.tile_h, tw = in.tile_w;
     
-    // Handle borders in parallel
-    #pragma omp parallel sections
-    {
-        #pragma omp section
-        {
-            // Top and bottom rows
-            for (int j = 0; j < cols; j++) {
-                output[j] = input[j];
-                output[(rows - 1) * cols + j] = input[(rows - 1) * cols + j];
-            }
+    if (h <= 0 || w <= 0) {
+        r0 = 0; c0 = 0; h = rows; w = cols;
+    }
+    if (r0 < 0 || c0 < 0 || r0 + h > rows || c0 + w > cols) {
+        fprintf(stderr, "Error: Region %dx%d+%d+%d is outside the %dx%d image\n",
+                w, h, c0, r0, cols, rows);
+        tileio_close(&in);
+        return -1;
+    }
+    
+    // Output tiles covering the region
+    int ty0 = r0 / th, ty1 = (r0 + h + th - 1) / th;
+    int tx0 = c0 / tw, tx1 = (c0 + w + tw - 1) / tw;
+    int out_r0 = ty0 * th, out_r1 = ty1 * th < rows ? ty1 * th : rows;
+    int out_c0 = tx0 * tw, out_c1 = tx1 * tw < cols ? tx1 * tw : cols;
+    
+    // Input window: output tiles plus the halo of the blur -> Sobel chain
+    int lo = out_r0 - 2 > 0 ? out_r0 - 2 : 0;
+    int hi = out_r1 + 2 < rows ? out_r1 + 2 : rows;
+    int clo = out_c0 - 2 > 0 ? out_c0 - 2 : 0;
+    int chi = out_c1 + 2 < cols ? out_c1 + 2 : cols;
+    int win_rows = hi - lo, win_cols = chi - clo;
+    
+    printf("Tiled input: %dx%d, tiles %dx%d, window %dx%d at (%d,%d)\n",
+           cols, rows, tw, th, win_cols, win_rows, clo, lo);
+    
+    size_t win_size = (size_t)win_rows * win_cols;
+    float *window = (float *)malloc(win_size * sizeof(float));
+    float *blurred = (float *)calloc(win_size, sizeof(float));
+    float *output = (float *)calloc(win_size, sizeof(float));
+    if (!window || !blurred || !output ||
+        tileio_read_region(&in, lo, clo, win_rows, win_cols, window) != 0) {
+        fprintf(stderr, "Error: Failed to read region from %s\n", input_filename);
+        free(window); free(blurred); free(output);
+        tileio_close(&in);
+        return -1;
+    }
+    tileio_close(&in);
+    
+    double start = omp_get_wtime();
+    
+    // Window coordinates: its frame only coincides with the image frame where
+    // the halo was clamped, so region kernels give full-image results
+    region_t blur_region = {
+        (out_r0 - 1 > 0 ? out_r0 - 1 : 0) - lo, (out_r1 + 1 < rows ? out_r1 + 1 : rows) - lo,
+        (out_c0 - 1 > 0 ? out_c0 - 1 : 0) - clo, (out_c1 + 1 < cols ? out_c1 + 1 : cols) - clo
+    };
+    region_t sobel_region = { out_r0 - lo, out_r1 - lo, out_c0 - clo, out_c1 - clo };
+    mean_blur_region(window, blurred, win_rows, win_cols, blur_region);
+    sobel_filter_region(blurred, output, win_rows, win_cols, sobel_region);
+    
+    double end = omp_get_wtime();
+    printf("Processing completed in %.6f seconds\n", end - start);
+    
+    // Output tiles are written in parallel, each with its own pwrite
+    tiled_image out;
+    if (tileio_create(output_filename, rows, cols, th, tw, &out) != 0) {
+        fprintf(stderr, "Error: Failed to create %s\n", output_filename);
+        free(window); free(blurred); free(output);
+        return -1;
+    }
+    
+    int failed = 0;
+    int num_out_tiles = (ty1 - ty0) * (tx1 - tx0);
+    #pragma omp parallel for schedule(dynamic) reduction(+:failed)
+    for (int k = 0; k < num_out_tiles; k++) {
+        int ty = ty0 + k / (tx1 - tx0);
+        int tx = tx0 + k % (tx1 - tx0);
+        if (tileio_write_tile(&out, ty, tx, output, lo, clo, win_cols) != 0) failed++;
+    }
+    tileio_close(&out);
+    
+    free(window);
+    free(blurred);
+    free(output);
+    
+    if (failed) {
+        fprintf(stderr, "Error: Failed to write %d tiles of %s\n", failed, output_filename);
+        return -1;
+    }
+    printf("Wrote %d output tiles: %s\n", num_out_tiles, output_filename);
+    return 0;
+}
+
+// Edge-list mode: the Sobel pass thresholds in place and emits only edge
+// pixels, which are written as a sparse .edg file (plus an optional PBM mask)
+static int run_edges(const float *input_image, float *blurred_image, int rows, int cols,
+                     float threshold, int want_mask, const char *size_tag) {
+    unsigned char *mask = NULL;
+    if (want_mask) {
+        mask = (unsigned char *)calloc((size_t)rows * ((cols + 7) / 8), 1);
+        if (!mask) {
+            fprintf(stderr, "Error: Failed to allocate mask\n");
+            return -1;
         }
-        
-        #pragma omp section
-        {
-            // Left and right columns
-            for (int i = 0; i < rows; i++) {
-                output[i * cols] = input[i * cols];
-                output[i * cols + (cols - 1)] = input[i * cols + (cols - 1)];
-            }
+    }
+    
+    double start = omp_get_wtime();
+    
+    mean_blur(input_image, blurred_image, rows, cols);
+    
+    edge_list edges;
+    if (sobel_filter_sparse(blurred_image, rows, cols, threshold, &edges, mask) != 0) {
+        fprintf(stderr, "Error: Failed to allocate edge list\n");
+        free(mask);
+        return -1;
+    }
+    
+    double end = omp_get_wtime();
+    printf("Processing completed in %.6f seconds\n", end - start);
+    printf("Edge pixels (magnitude >= %g): %ld of %ld (%.2f%%)\n", threshold, edges.count,
+           (long)rows * cols, 100.0 * edges.count / ((double)rows * cols));
+    
+    char edge_filename[256];
+    snprintf(edge_filename, sizeof(edge_filename), "%s/sobel_omp_%s.edg", OUTPUT_DIR, size_tag);
+    printf("Writing output: %s\n", edge_filename);
+    
+    double write_start = omp_get_wtime();
+    long bytes = edgewrite(edge_filename, &edges);
+    double write_end = omp_get_wtime();
+    edge_list_free(&edges);
+    
+    if (bytes < 0) {
+        fprintf(stderr, "Error: Failed to write %s\n", edge_filename);
+        free(mask);
+        return -1;
+    }
+    printf("Edge list: %ld bytes (dense PGM: %ld bytes) written in %.6f seconds\n",
+           bytes, (long)rows * cols, write_end - write_start);
+    
+    if (mask) {
+        char mask_filename[256];
+        snprintf(mask_filename, sizeof(mask_filename), "%s/sobel_omp_%s_mask.pbm", OUTPUT_DIR, size_tag);
+        printf("Writing mask: %s\n", mask_filename);
+        if (pbmwrite(mask_filename, mask, rows, cols) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", mask_filename);
+            free(mask);
+            return -1;
         }
+        free(mask);
     }
+    
+    printf("Output saved successfully\n");
+    return 0;
 }
 
-// Apply Sobel operator using OpenMP parallelization
-void sobel_filter(const float *input, float *output, int rows, int cols) {
-    // Sobel kernels
-    int Gx[3][3] = {
-        {-1, 0, 1},
-        {-2, 0, 2},
-        {-1, 0, 1}
-    };
+// Pyramid mode: Sobel maps of 'levels' 2x-downsampled levels in one pass over
+// the full-resolution image. Level 0 goes to the usual output file, level k
+// to sobel_omp_<size>_L<k>.pgm
+static int run_pyramid(const float *input_image, int rows, int cols, int levels,
+                       const exec_plan *plan, const char *size_tag) {
+    float *outputs[PYRAMID_MAX_LEVELS];
+    int status = 0;
     
-    int Gy[3][3] = {
-        {-1, -2, -1},
-        { 0,  0,  0},
-        { 1,  2,  1}
-    };
+    for (int k = 0; k < levels; k++) {
+        outputs[k] = (float *)malloc((size_t)(rows >> k) * (cols >> k) * sizeof(float));
+        if (!outputs[k]) status = -1;
+    }
     
-    // Parallelize the main computation
-    // static schedule: divide rows evenly among threads
-    #pragma omp parallel for schedule(static)
-    for (int i = 1; i < rows - 1; i++) {
-        for (int j = 1; j < cols - 1; j++) {
-            float sum_x = 0.0f;
-            float sum_y = 0.0f;
-            
-            // Apply 3x3 convolution
-            for (int ki = -1; ki <= 1; ki++) {
-                for (int kj = -1; kj <= 1; kj++) {
-                    float pixel = input[(i + ki) * cols + (j + kj)];
-                    sum_x += pixel * Gx[ki + 1][kj + 1];
-                    sum_y += pixel * Gy[ki + 1][kj + 1];
-                }
-            }
-            
-            // Compute gradient magnitude
-            float magnitude = sqrtf(sum_x * sum_x + sum_y * sum_y);
-            output[i * cols + j] = magnitude;
-        }
+    // The fused kernel needs bands to spread the work over the threads
+    int band_rows = plan->band_rows;
+    if (band_rows <= 0) band_rows = plan_default_band(rows, plan->threads);
+    
+    double start = omp_get_wtime();
+    if (status == 0 && blur_sobel_pyramid(input_image, outputs, levels, rows, cols,
+                                          band_rows, plan->tile_cols) != 0) {
+        status = -1;
+    }
+    double end = omp_get_wtime();
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to allocate pyramid levels\n");
+    } else {
+        printf("Processing completed in %.6f seconds (%d levels)\n", end - start, levels);
     }
     
-    // Handle borders in parallel
-    #pragma omp parallel sections
-    {
-        #pragma omp section
-        {
-            // Top and bottom rows
-            for (int j = 0; j < cols; j++) {
-                output[j] = 0.0f;
-                output[(rows - 1) * cols + j] = 0.0f;
-            }
+    double write_start = omp_get_wtime();
+    for (int k = 0; k < levels && status == 0; k++) {
+        char level_filename[256];
+        if (k == 0) {
+            snprintf(level_filename, sizeof(level_filename), "%s/sobel_omp_%s.pgm", OUTPUT_DIR, size_tag);
+        } else {
+            snprintf(level_filename, sizeof(level_filename), "%s/sobel_omp_%s_L%d.pgm", OUTPUT_DIR, size_tag, k);
         }
-        
-        #pragma omp section
-        {
-            // Left and right columns
-            for (int i = 0; i < rows; i++) {
-                output[i * cols] = 0.0f;
-                output[i * cols + (cols - 1)] = 0.0f;
-            }
+        printf("Writing level %d (%dx%d): %s\n", k, cols >> k, rows >> k, level_filename);
+        if (pgmwrite(level_filename, outputs[k], rows >> k, cols >> k, 1) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", level_filename);
+            status = -1;
         }
     }
+    if (status == 0) {
+        printf("Output saved successfully in %.6f seconds\n", omp_get_wtime() - write_start);
+    }
+    
+    for (int k = 0; k < levels; k++) free(outputs[k]);
+    return status;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <image_size>\n", argv[0]);
+    // Optional modes
+    int tiled = 0;
+    int roi[4] = { 0, 0, 0, 0 };
+    float edge_threshold = -1.0f;
+    int want_mask = 0;
+    int plan_override = -1;
+    int forced_threads = 0, forced_band = 0, forced_tile = -1;
+    int explain = 0, reprobe = 0;
+    int pyramid_levels = 0;
+    int orient_bins = 0;
+    int usage_error = argc < 2;
+    
+    for (int a = 2; a < argc && !usage_error; a++) {
+        if (strcmp(argv[a], "--tiled") == 0) {
+            tiled = 1;
+            if (a + 4 < argc && argv[a + 1][0] != '-') {
+                for (int k = 0; k < 4; k++) roi[k] = atoi(argv[a + 1 + k]);
+                a += 4;
+            }
+        } else if (strcmp(argv[a], "--edges") == 0 && a + 1 < argc) {
+            edge_threshold = (float)atof(argv[++a]);
+            if (edge_threshold <= 0.0f) usage_error = 1;
+        } else if (strcmp(argv[a], "--mask") == 0) {
+            want_mask = 1;
+        } else if (strcmp(argv[a], "--plan") == 0 && a + 1 < argc) {
+            a++;
+            if (strcmp(argv[a], "auto") != 0) {
+                for (int k = 0; k < 4; k++) {
+                    if (strcmp(argv[a], strategy_names[k]) == 0) plan_override = k;
+                }
+                if (plan_override < 0) usage_error = 1;
+            }
+        } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            forced_threads = atoi(argv[++a]);
+            if (forced_threads <= 0) usage_error = 1;
+        } else if (strcmp(argv[a], "--band") == 0 && a + 1 < argc) {
+            forced_band = atoi(argv[++a]);
+            if (forced_band <= 0) usage_error = 1;
+        } else if (strcmp(argv[a], "--tile") == 0 && a + 1 < argc) {
+            forced_tile = atoi(argv[++a]);
+            if (forced_tile < 0) usage_error = 1;
+        } else if (strcmp(argv[a], "--explain") == 0) {
+            explain = 1;
+        } else if (strcmp(argv[a], "--reprobe") == 0) {
+            reprobe = 1;
+        } else if (strcmp(argv[a], "--orient") == 0 && a + 1 < argc) {
+            orient_bins = atoi(argv[++a]);
+            if (orient_bins != 4 && orient_bins != 8 && orient_bins != 256) usage_error = 1;
+        } else if (strcmp(argv[a], "--pyramid") == 0 && a + 1 < argc) {
+            pyramid_levels = atoi(argv[++a]);
+            if (pyramid_levels < 1 || pyramid_levels > PYRAMID_MAX_LEVELS) usage_error = 1;
+        } else {
+            usage_error = 1;
+        }
+    }
+    if (want_mask && edge_threshold <= 0.0f) usage_error = 1;
+    if (pyramid_levels > 0 && (tiled || edge_threshold > 0.0f)) usage_error = 1;
+    if (orient_bins > 0 && (tiled || edge_threshold > 0.0f || pyramid_levels > 0)) usage_error = 1;
+    
+    if (usage_error) {
+        fprintf(stderr, "Usage: %s <image_size> [--tiled [row col height width]] [--edges <threshold> [--mask]] [--pyramid N] [--orient 4|8|256]\n", argv[0]);
         fprintf(stderr, "Example: %s 256 or %s 4k\n", argv[0], argv[0]);
+        fprintf(stderr, "--tiled reads sample_<size>.pgt (see pgmtile) and filters only the given region\n");
+        fprintf(stderr, "--edges writes only pixels with magnitude >= threshold as a sparse edge list\n");
+        fprintf(stderr, "--orient B also writes the gradient direction in B bins to sobel_omp_<size>_dir.pgm\n");
+        fprintf(stderr, "--pyramid N also writes Sobel maps of N-1 2x-downsampled levels (up to %d)\n",
+                PYRAMID_MAX_LEVELS);
+        fprintf(stderr, "Planning: [--plan auto|serial|threaded|fused|tiled] [--threads N] [--band rows] [--tile cols]\n");
+        fprintf(stderr, "          [--explain] [--reprobe]; OMP_NUM_THREADS also fixes the thread count\n");
         return 1;
     }
     
@@ -153,61 +330,130 @@ int main(int argc, char *argv[]) {
     // Build filenames
     char input_filename[256];
     char output_filename[256];
+    char size_tag[32];
     
     if (size >= 1000 && size % 1000 == 0) {
         int k_value = size / 1000;
-        snprintf(input_filename, sizeof(input_filename), "sample_%dk.pgm", k_value);
-        snprintf(output_filename, sizeof(output_filename), "%s/sobel_omp_%dk.pgm", OUTPUT_DIR, k_value);
+        snprintf(size_tag, sizeof(size_tag), "%dk", k_value);
     } else {
-        snprintf(input_filename, sizeof(input_filename), "sample_%d.pgm", size);
-        snprintf(output_filename, sizeof(output_filename), "%s/sobel_omp_%d.pgm", OUTPUT_DIR, size);
+        snprintf(size_tag, sizeof(size_tag), "%d", size);
     }
     
+    if (tiled) {
+        snprintf(input_filename, sizeof(input_filename), "sample_%s.pgt", size_tag);
+        snprintf(output_filename, sizeof(output_filename), "%s/sobel_omp_%s.pgt", OUTPUT_DIR, size_tag);
+        return run_tiled(input_filename, output_filename, roi[0], roi[1], roi[2], roi[3]) == 0 ? 0 : 1;
+    }
+    
+    snprintf(input_filename, sizeof(input_filename), "sample_%s.pgm", size_tag);
+    snprintf(output_filename, sizeof(output_filename), "%s/sobel_omp_%s.pgm", OUTPUT_DIR, size_tag);
+    
     // Read input image
     float *input_image = NULL;
     int rows, cols;
     
     printf("Reading image: %s\n", input_filename);
+    double read_start = omp_get_wtime();
     if (pgmread(input_filename, &input_image, &rows, &cols) != 0) {
         fprintf(stderr, "Error: Failed to read %s\n", input_filename);
         return 1;
     }
+    printf("Image read in %.6f seconds\n", omp_get_wtime() - read_start);
     
     if (rows != size || cols != size) {
         fprintf(stderr, "Warning: Image size is %dx%d, expected %dx%d\n", 
                 cols, rows, size, size);
     }
     
-    // Get number of threads
-    int num_threads;
-    #pragma omp parallel
-    {
-        #pragma omp master
-        num_threads = omp_get_num_threads();
+    // Plan execution from the host profile; explicit settings override it
+    const char *env_threads = getenv("OMP_NUM_THREADS");
+    if (forced_threads == 0 && env_threads && atoi(env_threads) > 0) {
+        forced_threads = atoi(env_threads);
     }
     
+    host_profile profile;
+    exec_plan plan;
+    profile_get(&profile, reprobe);
+    plan_execution(&profile, rows, cols, forced_threads, &plan);
+    
+    if (plan_override >= 0 && plan_override != (int)plan.strategy) {
+        plan.strategy = (strategy_t)plan_override;
+        if (plan.strategy == STRATEGY_SERIAL) plan.threads = 1;
+        if (plan.strategy == STRATEGY_FUSED || plan.strategy == STRATEGY_TILED) {
+            plan.band_rows = plan_default_band(rows, plan.threads);
+        }
+        if (plan.strategy == STRATEGY_TILED && plan.tile_cols == 0) plan.tile_cols = 256;
+        if (plan.strategy != STRATEGY_TILED) plan.tile_cols = 0;
+        snprintf(plan.reason, sizeof(plan.reason), "%s requested with --plan", strategy_names[plan.strategy]);
+    }
+    if (forced_band > 0) plan.band_rows = forced_band;
+    if (forced_tile >= 0) plan.tile_cols = forced_tile;
+    omp_set_num_threads(plan.threads);
+    
     printf("Image loaded: %dx%d\n", cols, rows);
-    printf("OpenMP threads: %d\n", num_threads);
+    printf("OpenMP threads: %d\n", plan.threads);
+    printf("Plan: %s (band %d rows, tile %d cols)\n",
+           strategy_names[plan.strategy], plan.band_rows, plan.tile_cols);
+    if (explain) {
+        plan_print_profile(&profile);
+        printf("Reason: %s\n", plan.reason);
+    }
+    
+    if (pyramid_levels > 0) {
+        // Keep only the levels that are still at least 3x3
+        int levels = 1;
+        while (levels < pyramid_levels && (rows >> levels) >= 3 && (cols >> levels) >= 3) levels++;
+        if (levels < pyramid_levels) {
+            fprintf(stderr, "Warning: %dx%d image only has %d pyramid levels of at least 3x3\n",
+                    cols, rows, levels);
+        }
+        int status = run_pyramid(input_image, rows, cols, levels, &plan, size_tag);
+        free(input_image);
+        return status == 0 ? 0 : 1;
+    }
     
-    // Allocate buffers
-    float *blurred_image = (float *)calloc(rows * cols, sizeof(float));
+    // Allocate buffers; the fused strategies never materialize the blur
+    // (orientation comes from the two-pass Sobel)
+    int two_pass = plan.strategy == STRATEGY_SERIAL || plan.strategy == STRATEGY_THREADED ||
+                   edge_threshold > 0.0f || orient_bins > 0;
+    float *blurred_image = two_pass ? (float *)calloc(rows * cols, sizeof(float)) : NULL;
     float *output_image = (float *)calloc(rows * cols, sizeof(float));
-    if (!blurred_image || !output_image) {
+    unsigned char *direction = orient_bins > 0 ? (unsigned char *)malloc((size_t)rows * cols) : NULL;
+    if ((two_pass && !blurred_image) || !output_image || (orient_bins > 0 && !direction)) {
         fprintf(stderr, "Error: Failed to allocate buffers\n");
         free(input_image);
         if (blurred_image) free(blurred_image);
         if (output_image) free(output_image);
+        free(direction);
         return 1;
     }
     
+    if (edge_threshold > 0.0f) {
+        int status = run_edges(input_image, blurred_image, rows, cols, edge_threshold,
+                               want_mask, size_tag);
+        free(input_image);
+        free(blurred_image);
+        free(output_image);
+        return status == 0 ? 0 : 1;
+    }
+    
     // Start timing (exclude I/O)
     double start = omp_get_wtime();
     
-    // Step 1: Apply mean blur filter
-    mean_blur(input_image, blurred_image, rows, cols);
-    
-    // Step 2: Apply Sobel filter
-    sobel_filter(blurred_image, output_image, rows, cols);
+    if (two_pass) {
+        // Step 1: Apply mean blur filter
+        mean_blur(input_image, blurred_image, rows, cols);
+        
+        // Step 2: Apply Sobel filter (with the direction from the same sums)
+        if (direction) {
+            sobel_filter_oriented(blurred_image, output_image, direction, rows, cols, orient_bins);
+        } else {
+            sobel_filter(blurred_image, output_image, rows, cols);
+        }
+    } else {
+        // Blur and Sobel in one pass over row bands (and column tiles)
+        blur_sobel_fused(input_image, output_image, rows, cols, plan.band_rows, plan.tile_cols);
+    }
     
     // End timing
     double end = omp_get_wtime();
@@ -217,20 +463,37 @@ int main(int argc, char *argv[]) {
     
     // Write output
     printf("Writing output: %s\n", output_filename);
+    double write_start = omp_get_wtime();
     if (pgmwrite(output_filename, output_image, rows, cols, 1) != 0) {
         fprintf(stderr, "Error: Failed to write %s\n", output_filename);
         free(input_image);
         free(blurred_image);
         free(output_image);
+        free(direction);
         return 1;
     }
     
-    printf("Output saved successfully\n");
+    printf("Output saved successfully in %.6f seconds\n", omp_get_wtime() - write_start);
+    
+    if (direction) {
+        char direction_filename[256];
+        snprintf(direction_filename, sizeof(direction_filename), "%s/sobel_omp_%s_dir.pgm", OUTPUT_DIR, size_tag);
+        printf("Writing direction (%d bins): %s\n", orient_bins, direction_filename);
+        if (pgmwrite_bytes(direction_filename, direction, rows, cols, orient_bins - 1) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", direction_filename);
+            free(input_image);
+            free(blurred_image);
+            free(output_image);
+            free(direction);
+            return 1;
+        }
+    }
     
     // Cleanup
     free(input_image);
     free(blurred_image);
     free(output_image);
+    free(direction);
     
     return 0;
 }
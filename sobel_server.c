@@ -0,0 +1,607 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <omp.h>
+#include "pgmio.h"
+#include "sobel_kernels.h"
+
+// Persistent filter server: keeps the OpenMP team and the blur/output
+// buffers warm between jobs and takes jobs over a local UNIX socket.
+//
+// A job is either a pair of PGM paths, or a shared-memory file descriptor
+// (memfd passed with SCM_RIGHTS) holding rows*cols input floats followed by
+// rows*cols output floats, filtered in place without copying pixels.
+// Jobs that arrive within the batch window are run together: small images
+// one per thread, large images one after another on the whole team.
+
+#define DEFAULT_BATCH_US 500
+#define MAX_BATCH 32
+#define MAX_CLIENTS 64
+#define SMALL_JOB_PIXELS (512 * 512)
+#define WARM_PIXELS (1024 * 1024)
+#define LATENCY_WINDOW 4096
+#define REQUEST_TIMEOUT_S 5.0   // drop clients that stall mid-request
+
+enum { JOB_PATH, JOB_SHM, JOB_STATS, JOB_SHUTDOWN };
+
+typedef struct {
+    int op;
+    int rows, cols;             // JOB_SHM: image size in the shared buffer
+    char in_path[256];
+    char out_path[256];
+} job_request;
+
+typedef struct {
+    int status;                 // 0 on success, -1 on error
+    int rows, cols;
+    int batch_size;             // number of jobs run in the same batch
+    double queue_us;            // time between receipt and start of the batch
+    double compute_us;          // filter time of the batch this job ran in
+    char text[1024];            // error or statistics text
+} job_reply;
+
+// Blur and output buffers, grown on demand and reused across batches
+typedef struct {
+    float *blurred;
+    float *output;
+    size_t capacity;
+} buffer_slot;
+
+typedef struct {
+    int fd;                     // client connection
+    job_request req;
+    int shm_fd;
+    float *map;                 // JOB_SHM: mapped input + output planes
+    size_t map_bytes;
+    float *input, *output;
+    double received;
+    job_reply reply;
+} job;
+
+// Per-connection receive state: client sockets are non-blocking, so a
+// request may arrive in pieces over several poll rounds
+typedef struct {
+    job_request req;
+    size_t have;                // bytes of req received so far
+    int shm_fd;                 // descriptor passed with the request, or -1
+    double started;             // arrival of the first byte of req
+} connection;
+
+typedef struct {
+    double start;
+    long jobs, failed, batches;
+    double pixels;
+    double compute_s;
+    double latency_us[LATENCY_WINDOW];
+    long latency_count;
+} server_stats;
+
+static int slot_reserve(buffer_slot *s, size_t pixels) {
+    if (pixels <= s->capacity) return 0;
+    float *blurred = (float *)realloc(s->blurred, pixels * sizeof(float));
+    if (!blurred) return -1;
+    s->blurred = blurred;
+    float *output = (float *)realloc(s->output, pixels * sizeof(float));
+    if (!output) return -1;
+    s->output = output;
+    s->capacity = pixels;
+    return 0;
+}
+
+// Start the thread team and fault in the pooled buffers, each slot from the
+// thread that is most likely to use it
+static int server_warm(buffer_slot *slots, int num_slots) {
+    int failed = 0;
+    for (int s = 0; s < num_slots; s++) {
+        if (slot_reserve(&slots[s], WARM_PIXELS) != 0) failed = 1;
+    }
+    if (failed) return -1;
+    #pragma omp parallel for schedule(static)
+    for (int s = 0; s < num_slots; s++) {
+        memset(slots[s].blurred, 0, WARM_PIXELS * sizeof(float));
+        memset(slots[s].output, 0, WARM_PIXELS * sizeof(float));
+    }
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void stats_format(const server_stats *st, char *text, size_t size) {
+    double uptime = omp_get_wtime() - st->start;
+    long n = st->latency_count < LATENCY_WINDOW ? st->latency_count : LATENCY_WINDOW;
+    double p50 = 0.0, p99 = 0.0, max = 0.0;
+    if (n > 0) {
+        double *sorted = (double *)malloc(n * sizeof(double));
+        if (sorted) {
+            memcpy(sorted, st->latency_us, n * sizeof(double));
+            qsort(sorted, n, sizeof(double), cmp_double);
+            p50 = sorted[n / 2];
+            p99 = sorted[(n * 99) / 100 < n ? (n * 99) / 100 : n - 1];
+            max = sorted[n - 1];
+            free(sorted);
+        }
+    }
+    snprintf(text, size,
+             "Uptime: %.1f s | Jobs: %ld (%ld failed) | Batches: %ld (%.2f jobs/batch)\n"
+             "Throughput: %.1f jobs/s, %.2f Mpixel/s overall, %.2f Mpixel/s while computing\n"
+             "Latency (last %ld jobs): p50 %.1f us | p99 %.1f us | max %.1f us\n",
+             uptime, st->jobs, st->failed, st->batches,
+             st->batches > 0 ? (double)st->jobs / st->batches : 0.0,
+             uptime > 0.0 ? st->jobs / uptime : 0.0,
+             uptime > 0.0 ? st->pixels / uptime / 1e6 : 0.0,
+             st->compute_s > 0.0 ? st->pixels / st->compute_s / 1e6 : 0.0,
+             n, p50, p99, max);
+}
+
+// Read what is available of a request, plus the descriptor that comes with
+// JOB_SHM. Returns 1 when the request is complete, 0 while it is still
+// partial, -1 when the client hung up or on error.
+static int recv_request(int fd, connection *conn) {
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { (char *)&conn->req + conn->have, sizeof(conn->req) - conn->have };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n = recvmsg(fd, &msg, 0);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    if (n == 0) return -1;
+
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            int passed;
+            memcpy(&passed, CMSG_DATA(c), sizeof(int));
+            if (conn->shm_fd >= 0) close(passed);
+            else conn->shm_fd = passed;
+        }
+    }
+    if (conn->have == 0) conn->started = omp_get_wtime();
+    conn->have += (size_t)n;
+    if (conn->have < sizeof(conn->req)) return 0;
+
+    conn->req.in_path[sizeof(conn->req.in_path) - 1] = '\0';
+    conn->req.out_path[sizeof(conn->req.out_path) - 1] = '\0';
+    return 1;
+}
+
+static void connection_reset(connection *conn) {
+    if (conn->shm_fd >= 0) close(conn->shm_fd);
+    memset(conn, 0, sizeof(*conn));
+    conn->shm_fd = -1;
+}
+
+static int send_request(int fd, const job_request *req, int shm_fd) {
+    char control[CMSG_SPACE(sizeof(int))];
+    struct iovec iov = { (void *)req, sizeof(*req) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (shm_fd >= 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &shm_fd, sizeof(int));
+    }
+    return sendmsg(fd, &msg, 0) == (ssize_t)sizeof(*req) ? 0 : -1;
+}
+
+// Load the pixels of a job: read the PGM or map the shared buffer
+static int job_prepare(job *j, buffer_slot *slot) {
+    job_reply *r = &j->reply;
+    if (j->req.op == JOB_SHM) {
+        struct stat sb;
+        size_t pixels = (size_t)j->req.rows * j->req.cols;
+        if (j->shm_fd < 0 || j->req.rows <= 0 || j->req.cols <= 0 ||
+            fstat(j->shm_fd, &sb) != 0 || (size_t)sb.st_size < 2 * pixels * sizeof(float)) {
+            snprintf(r->text, sizeof(r->text), "Error: Shared buffer missing or smaller than %dx%d", j->req.cols, j->req.rows);
+            return -1;
+        }
+        j->map_bytes = 2 * pixels * sizeof(float);
+        j->map = (float *)mmap(NULL, j->map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, j->shm_fd, 0);
+        if (j->map == MAP_FAILED) {
+            j->map = NULL;
+            snprintf(r->text, sizeof(r->text), "Error: mmap failed: %s", strerror(errno));
+            return -1;
+        }
+        j->input = j->map;
+        j->output = j->map + pixels;
+        r->rows = j->req.rows;
+        r->cols = j->req.cols;
+    } else {
+        if (pgmread(j->req.in_path, &j->input, &r->rows, &r->cols) != 0) {
+            snprintf(r->text, sizeof(r->text), "Error: Failed to read %s", j->req.in_path);
+            return -1;
+        }
+    }
+    if (slot_reserve(slot, (size_t)r->rows * r->cols) != 0) {
+        snprintf(r->text, sizeof(r->text), "Error: Failed to allocate image buffers");
+        return -1;
+    }
+    if (j->req.op == JOB_PATH) j->output = slot->output;
+    return 0;
+}
+
+static void job_release(job *j) {
+    if (j->map) munmap(j->map, j->map_bytes);
+    else free(j->input);
+    if (j->shm_fd >= 0) close(j->shm_fd);
+    j->map = NULL;
+    j->input = NULL;
+    j->shm_fd = -1;
+}
+
+// Run a batch of filter jobs and answer each client
+static void run_batch(job *jobs, int count, buffer_slot *slots, server_stats *st) {
+    double batch_start = omp_get_wtime();
+    int ok[MAX_BATCH];
+    for (int k = 0; k < count; k++) {
+        memset(&jobs[k].reply, 0, sizeof(jobs[k].reply));
+        ok[k] = job_prepare(&jobs[k], &slots[k]) == 0;
+    }
+
+    // Small images: one job per thread (the kernels' own parallel regions
+    // are nested and run on that thread). Large images: the whole team.
+    double t0 = omp_get_wtime();
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int k = 0; k < count; k++) {
+        job_reply *r = &jobs[k].reply;
+        if (ok[k] && (long)r->rows * r->cols < SMALL_JOB_PIXELS) {
+            mean_blur(jobs[k].input, slots[k].blurred, r->rows, r->cols);
+            sobel_filter(slots[k].blurred, jobs[k].output, r->rows, r->cols);
+        }
+    }
+    for (int k = 0; k < count; k++) {
+        job_reply *r = &jobs[k].reply;
+        if (ok[k] && (long)r->rows * r->cols >= SMALL_JOB_PIXELS) {
+            mean_blur(jobs[k].input, slots[k].blurred, r->rows, r->cols);
+            sobel_filter(slots[k].blurred, jobs[k].output, r->rows, r->cols);
+        }
+    }
+    double compute = omp_get_wtime() - t0;
+
+    st->batches++;
+    st->compute_s += compute;
+    for (int k = 0; k < count; k++) {
+        job *j = &jobs[k];
+        job_reply *r = &j->reply;
+        if (ok[k] && j->req.op == JOB_PATH && pgmwrite(j->req.out_path, j->output, r->rows, r->cols, 1) != 0) {
+            snprintf(r->text, sizeof(r->text), "Error: Failed to write %s", j->req.out_path);
+            ok[k] = 0;
+        }
+        r->status = ok[k] ? 0 : -1;
+        r->batch_size = count;
+        r->queue_us = (batch_start - j->received) * 1e6;
+        r->compute_us = compute * 1e6;
+        job_release(j);
+
+        if (send(j->fd, r, sizeof(*r), MSG_NOSIGNAL) != (ssize_t)sizeof(*r)) ok[k] = 0;
+        st->jobs++;
+        if (ok[k]) {
+            st->pixels += (double)r->rows * r->cols;
+            st->latency_us[st->latency_count++ % LATENCY_WINDOW] = (omp_get_wtime() - j->received) * 1e6;
+        } else {
+            st->failed++;
+        }
+    }
+}
+
+static int serve(const char *socket_path, int batch_us, int max_batch) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path too long\n");
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) { perror("socket"); return 1; }
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, MAX_CLIENTS) != 0) {
+        perror("bind");
+        close(listen_fd);
+        return 1;
+    }
+
+    buffer_slot slots[MAX_BATCH];
+    memset(slots, 0, sizeof(slots));
+    double t0 = omp_get_wtime();
+    if (server_warm(slots, max_batch) != 0) {
+        fprintf(stderr, "Error: Failed to allocate buffer pool\n");
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+    printf("Listening on %s | threads %d | batch window %d us | max batch %d | warm-up %.3f s\n",
+           socket_path, omp_get_max_threads(), batch_us, max_batch, omp_get_wtime() - t0);
+    fflush(stdout);
+
+    server_stats st;
+    memset(&st, 0, sizeof(st));
+    st.start = omp_get_wtime();
+
+    struct pollfd fds[MAX_CLIENTS + 1];
+    connection conns[MAX_CLIENTS + 1];
+    int num_fds = 1;
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    job pending[MAX_BATCH];
+    int num_pending = 0;
+    double deadline = 0.0;
+    int running = 1;
+
+    while (running) {
+        // Wake for the batch deadline or the oldest stalled partial request
+        double wake = num_pending > 0 ? deadline : 0.0;
+        for (int c = 1; c < num_fds; c++) {
+            double stall = conns[c].started + REQUEST_TIMEOUT_S;
+            if (conns[c].have > 0 && (wake == 0.0 || stall < wake)) wake = stall;
+        }
+        int timeout = -1;
+        if (wake > 0.0) {
+            double left = wake - omp_get_wtime();
+            timeout = left > 0.0 ? (int)(left * 1000.0 + 0.999) : 0;
+        }
+        if (poll(fds, num_fds, timeout) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0 && num_fds <= MAX_CLIENTS && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0) {
+                memset(&conns[num_fds], 0, sizeof(conns[num_fds]));
+                conns[num_fds].shm_fd = -1;
+                fds[num_fds].fd = fd;
+                fds[num_fds].events = POLLIN;
+                fds[num_fds].revents = 0;
+                num_fds++;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        for (int c = 1; c < num_fds && num_pending < max_batch; c++) {
+            // Clients with a job in the batch are not read until it is answered
+            if (fds[c].events == 0 || !(fds[c].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            fds[c].revents = 0;
+
+            int got = recv_request(fds[c].fd, &conns[c]);
+            if (got < 0) {
+                connection_reset(&conns[c]);
+                close(fds[c].fd);
+                num_fds--;
+                fds[c] = fds[num_fds];
+                conns[c] = conns[num_fds];
+                c--;
+                continue;
+            }
+            if (got == 0) continue;
+
+            // Whole request: it moves from the connection to the job
+            job *j = &pending[num_pending];
+            memset(j, 0, sizeof(*j));
+            j->req = conns[c].req;
+            j->shm_fd = conns[c].shm_fd;
+            conns[c].shm_fd = -1;
+            connection_reset(&conns[c]);
+            if (j->req.op == JOB_STATS || j->req.op == JOB_SHUTDOWN) {
+                if (j->shm_fd >= 0) close(j->shm_fd);
+                j->shm_fd = -1;
+            }
+
+            if (j->req.op == JOB_STATS) {
+                job_reply r;
+                memset(&r, 0, sizeof(r));
+                stats_format(&st, r.text, sizeof(r.text));
+                send(fds[c].fd, &r, sizeof(r), MSG_NOSIGNAL);
+            } else if (j->req.op == JOB_SHUTDOWN) {
+                job_reply r;
+                memset(&r, 0, sizeof(r));
+                snprintf(r.text, sizeof(r.text), "Shutting down");
+                send(fds[c].fd, &r, sizeof(r), MSG_NOSIGNAL);
+                running = 0;
+            } else {
+                j->fd = fds[c].fd;
+                j->received = omp_get_wtime();
+                fds[c].events = 0;
+                if (num_pending++ == 0) deadline = j->received + batch_us * 1e-6;
+            }
+        }
+
+        // Drop clients that sent part of a request and then stalled
+        double now = omp_get_wtime();
+        for (int c = 1; c < num_fds; c++) {
+            if (conns[c].have > 0 && now - conns[c].started > REQUEST_TIMEOUT_S) {
+                fprintf(stderr, "Warning: Dropping client stalled after %zu of %zu request bytes\n",
+                        conns[c].have, sizeof(conns[c].req));
+                connection_reset(&conns[c]);
+                close(fds[c].fd);
+                num_fds--;
+                fds[c] = fds[num_fds];
+                conns[c] = conns[num_fds];
+                c--;
+            }
+        }
+
+        if (num_pending > 0 && (num_pending == max_batch || omp_get_wtime() >= deadline || !running)) {
+            run_batch(pending, num_pending, slots, &st);
+            for (int k = 0; k < num_pending; k++) {
+                for (int c = 1; c < num_fds; c++) {
+                    if (fds[c].fd == pending[k].fd) fds[c].events = POLLIN;
+                }
+            }
+            num_pending = 0;
+        }
+    }
+
+    char text[1024];
+    stats_format(&st, text, sizeof(text));
+    printf("%s", text);
+
+    for (int c = 1; c < num_fds; c++) {
+        connection_reset(&conns[c]);
+        close(fds[c].fd);
+    }
+    close(listen_fd);
+    unlink(socket_path);
+    for (int s = 0; s < MAX_BATCH; s++) {
+        free(slots[s].blurred);
+        free(slots[s].output);
+    }
+    return 0;
+}
+
+static int client_connect(const char *socket_path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { perror("socket"); return -1; }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int client_call(int fd, const job_request *req, int shm_fd, job_reply *reply) {
+    if (send_request(fd, req, shm_fd) != 0 ||
+        recv(fd, reply, sizeof(*reply), MSG_WAITALL) != (ssize_t)sizeof(*reply)) {
+        fprintf(stderr, "Error: Lost connection to server\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Filter one image through the server, 'repeat' times on one connection
+static int run_client(const char *socket_path, const char *in_path, const char *out_path, int use_shm, int repeat) {
+    int fd = client_connect(socket_path);
+    if (fd < 0) return 1;
+
+    job_request req;
+    memset(&req, 0, sizeof(req));
+    int shm_fd = -1;
+    float *map = NULL;
+    size_t map_bytes = 0;
+
+    if (use_shm) {
+        // Client pays the PGM I/O; the server only touches the shared floats
+        float *image = NULL;
+        if (pgmread(in_path, &image, &req.rows, &req.cols) != 0) {
+            fprintf(stderr, "Error: Failed to read %s\n", in_path);
+            close(fd);
+            return 1;
+        }
+        size_t pixels = (size_t)req.rows * req.cols;
+        map_bytes = 2 * pixels * sizeof(float);
+        shm_fd = memfd_create("sobel_job", MFD_CLOEXEC);
+        if (shm_fd < 0 || ftruncate(shm_fd, (off_t)map_bytes) != 0 ||
+            (map = (float *)mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0)) == MAP_FAILED) {
+            perror("memfd");
+            free(image);
+            close(fd);
+            return 1;
+        }
+        memcpy(map, image, pixels * sizeof(float));
+        free(image);
+        req.op = JOB_SHM;
+    } else {
+        req.op = JOB_PATH;
+        snprintf(req.in_path, sizeof(req.in_path), "%s", in_path);
+        snprintf(req.out_path, sizeof(req.out_path), "%s", out_path);
+    }
+
+    int status = 0;
+    double t0 = omp_get_wtime();
+    job_reply reply;
+    for (int k = 0; k < repeat && status == 0; k++) {
+        if (client_call(fd, &req, shm_fd, &reply) != 0) {
+            status = 1;
+        } else if (reply.status != 0) {
+            fprintf(stderr, "%s\n", reply.text);
+            status = 1;
+        }
+    }
+    double elapsed = omp_get_wtime() - t0;
+
+    if (status == 0) {
+        printf("Image %dx%d | %d job(s) in %.6f seconds (%.1f us/job) | last: queue %.1f us, batch of %d computed in %.1f us\n",
+               reply.cols, reply.rows, repeat, elapsed, elapsed * 1e6 / repeat,
+               reply.queue_us, reply.batch_size, reply.compute_us);
+        if (use_shm && pgmwrite(out_path, map + (size_t)req.rows * req.cols, req.rows, req.cols, 1) != 0) {
+            fprintf(stderr, "Error: Failed to write %s\n", out_path);
+            status = 1;
+        }
+    }
+
+    if (map) munmap(map, map_bytes);
+    if (shm_fd >= 0) close(shm_fd);
+    close(fd);
+    return status;
+}
+
+static int run_control(const char *socket_path, int op) {
+    int fd = client_connect(socket_path);
+    if (fd < 0) return 1;
+    job_request req;
+    job_reply reply;
+    memset(&req, 0, sizeof(req));
+    req.op = op;
+    int status = client_call(fd, &req, -1, &reply) == 0 ? 0 : 1;
+    if (status == 0) printf("%s%s", reply.text, op == JOB_SHUTDOWN ? "\n" : "");
+    close(fd);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "serve") == 0) {
+        int batch_us = argc > 3 ? atoi(argv[3]) : DEFAULT_BATCH_US;
+        int max_batch = argc > 4 ? atoi(argv[4]) : MAX_BATCH;
+        if (batch_us < 0 || max_batch < 1 || max_batch > MAX_BATCH) {
+            fprintf(stderr, "Error: batch window must be >= 0 and max batch in 1..%d\n", MAX_BATCH);
+            return 1;
+        }
+        signal(SIGPIPE, SIG_IGN);
+        return serve(argv[2], batch_us, max_batch);
+    }
+    if (argc >= 5 && (strcmp(argv[1], "run") == 0 || strcmp(argv[1], "run-shm") == 0)) {
+        int repeat = argc > 5 ? atoi(argv[5]) : 1;
+        if (repeat < 1) repeat = 1;
+        return run_client(argv[2], argv[3], argv[4], strcmp(argv[1], "run-shm") == 0, repeat);
+    }
+    if (argc == 3 && strcmp(argv[1], "stats") == 0) return run_control(argv[2], JOB_STATS);
+    if (argc == 3 && strcmp(argv[1], "stop") == 0) return run_control(argv[2], JOB_SHUTDOWN);
+
+    fprintf(stderr, "Usage: %s serve <socket> [batch_window_us] [max_batch]\n", argv[0]);
+    fprintf(stderr, "       %s run|run-shm <socket> <input.pgm> <output.pgm> [repeat]\n", argv[0]);
+    fprintf(stderr, "       %s stats|stop <socket>\n", argv[0]);
+    fprintf(stderr, "Example: %s serve /tmp/sobel.sock & %s run /tmp/sobel.sock sample_256.pgm output/sobel_256.pgm\n",
+            argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,438 @@
+#!/bin/bash
+
+# --- Cross-implementation regression gate ---
+# Builds every variant (serial, OpenMP, MPI, server), runs them over
+# synthetic images and the sample images, and diffs each output pixel by
+# pixel against an independent reference filter (pgmcheck ref). Then, if
+# given baselines or --record, times the sample sizes and compares them
+# against the baseline CSVs. Any mismatch or slowdown makes the script exit
+# non-zero.
+#
+# The timing gate only means something against baselines from the same
+# machine and build: report/*.csv were measured on the course cluster, so
+# use BASELINE_DIR=report there, and elsewhere record local baselines first
+# (./test_regression.sh --record baselines, then BASELINE_DIR=baselines).
+# --record also writes DIR/build.conf (compiler flags and any in-source
+# optimisation overrides); the gate refuses to compare against a baseline
+# directory whose build.conf is missing or differs from the current build.
+#
+# Usage: ./test_regression.sh [--no-mpi] [--no-perf] [--record DIR]
+#   --no-mpi      skip the MPI variants
+#   --no-perf     correctness only
+#   --record DIR  time the samples and write DIR/*.csv (same format as
+#                 report/), e.g. to make baselines for this machine
+#
+# Environment:
+#   PIXEL_TOLERANCE  max allowed difference in gray levels (default 1)
+#   PERF_TOLERANCE   allowed slowdown over the baseline median (default 0.25)
+#   BASELINE_DIR     directory with the baseline CSVs; without it (and
+#                    without --record) the timing gate is skipped
+#   BUILD_FLAGS      extra compiler flags for the filter programs (default
+#                    none, as for the benchmarks)
+#   MPI_PROCS        process counts for the MPI checks (default "1 2 3 4")
+#   MPIRUN           MPI launcher (default "mpirun --oversubscribe")
+
+ROOT=$(cd "$(dirname "$0")" && pwd)
+WORK="$ROOT/regression"
+PIXEL_TOLERANCE=${PIXEL_TOLERANCE:-1}
+PERF_TOLERANCE=${PERF_TOLERANCE:-0.25}
+BASELINE_DIR=${BASELINE_DIR:-}
+BUILD_FLAGS=${BUILD_FLAGS:-}
+MPI_PROCS=${MPI_PROCS:-"1 2 3 4"}
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+RUN_MPI=1
+RUN_PERF=1
+RECORD_DIR=""
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --no-mpi) RUN_MPI=0 ;;
+        --no-perf) RUN_PERF=0 ;;
+        --record) RECORD_DIR="$2"; shift ;;
+        *) echo "Usage: $0 [--no-mpi] [--no-perf] [--record DIR]" >&2; exit 1 ;;
+    esac
+    shift
+done
+# The tests run in $WORK/data, so make the CSV directories absolute
+case "$BASELINE_DIR" in ""|/*) ;; *) BASELINE_DIR="$PWD/$BASELINE_DIR" ;; esac
+case "$RECORD_DIR" in ""|/*) ;; *) RECORD_DIR="$PWD/$RECORD_DIR" ;; esac
+
+if [ "$RUN_MPI" = 1 ] && ! command -v mpicc > /dev/null; then
+    echo "mpicc not found: skipping MPI variants"
+    RUN_MPI=0
+fi
+# Open MPI refuses to run as root unless asked
+if [ "$(id -u)" = 0 ]; then
+    MPIRUN="$MPIRUN --allow-run-as-root"
+fi
+
+passed=0
+failed=0
+failures=()
+
+pass() { passed=$((passed + 1)); printf "  PASS  %s\n" "$1"; }
+fail() { failed=$((failed + 1)); failures+=("$1"); printf "  FAIL  %s\n" "$1"; }
+
+# ===================================================================
+# Build (no optimisation flags unless BUILD_FLAGS, as for the benchmarks)
+# ===================================================================
+echo "=========================================="
+echo "Building variants"
+echo "=========================================="
+mkdir -p "$WORK/bin" "$WORK/data/output"
+BIN="$WORK/bin"
+build() {
+    local name=$1; shift
+    if "$@" 2> "$BIN/$name.log"; then
+        echo "  built $name"
+    else
+        cat "$BIN/$name.log"
+        fail "build $name"
+    fi
+}
+build pgmcheck gcc "$ROOT/pgmcheck.c" -o "$BIN/pgmcheck" -lm
+build pgmtile gcc "$ROOT/pgmtile.c" -o "$BIN/pgmtile"
+build sobel gcc $BUILD_FLAGS "$ROOT/sobel.c" "$ROOT/sobel_kernels.cpp" -o "$BIN/sobel" -lstdc++ -lm
+build sobel_omp gcc $BUILD_FLAGS -fopenmp "$ROOT/sobel_omp.c" "$ROOT/sobel_kernels.cpp" -o "$BIN/sobel_omp" -lstdc++ -lm
+build sobel_server gcc $BUILD_FLAGS -fopenmp "$ROOT/sobel_server.c" "$ROOT/sobel_kernels.cpp" -o "$BIN/sobel_server" -lstdc++ -lm
+if [ "$RUN_MPI" = 1 ]; then
+    build sobel_mpi mpicc $BUILD_FLAGS "$ROOT/sobel_mpi.c" "$ROOT/sobel_kernels.cpp" -o "$BIN/sobel_mpi" -lstdc++ -lm
+fi
+if [ "$failed" -gt 0 ]; then
+    echo "Build failed"
+    exit 1
+fi
+
+# ===================================================================
+# Test images: synthetic shapes chosen to hit the edge cases (tiny,
+# non-square, odd sizes, a "k" size tag) plus the sample images
+# ===================================================================
+cd "$WORK/data" || exit 1
+export SOBEL_PROFILE="$WORK/data/.sobel_profile"
+
+# tag rows cols pattern
+synthetic="3 3 3 noise
+5 5 17 checker
+97 97 131 noise
+130 130 64 step
+200 200 200 gradient
+257 257 300 checker
+1k 1000 1000 noise"
+
+tags=()
+while read -r tag rows cols pattern; do
+    "$BIN/pgmcheck" gen "$rows" "$cols" "$pattern" 42 "sample_$tag.pgm"
+    tags+=("$tag")
+done <<< "$synthetic"
+for size in 256 1024 4k 16k; do
+    if [ -f "$ROOT/sample_$size.pgm" ]; then
+        ln -sf "$ROOT/sample_$size.pgm" "sample_$size.pgm"
+        tags+=("$size")
+    fi
+done
+
+# Size argument for a tag ("1k" -> 1000)
+size_of() {
+    case "$1" in
+        *k) echo $(( ${1%k} * 1000 )) ;;
+        *) echo "$1" ;;
+    esac
+}
+
+# check <label> <output.pgm> <reference.pgm>
+check() {
+    local result
+    if [ ! -f "$2" ]; then
+        fail "$1: no output"
+        return
+    fi
+    result=$("$BIN/pgmcheck" diff "$2" "$3" "$PIXEL_TOLERANCE")
+    if [ $? = 0 ]; then
+        pass "$1"
+    else
+        fail "$1: $result"
+    fi
+    rm -f "$2"
+}
+
+# ===================================================================
+# Correctness
+# ===================================================================
+echo ""
+echo "=========================================="
+echo "Correctness (tolerance: $PIXEL_TOLERANCE gray levels)"
+echo "=========================================="
+for tag in "${tags[@]}"; do
+    size=$(size_of "$tag")
+    ref="ref_$tag.pgm"
+    "$BIN/pgmcheck" ref "sample_$tag.pgm" "$ref"
+    echo "Image $tag:"
+
+    "$BIN/sobel" "$size" > /dev/null
+    check "sequential $tag" "output/sobel_$tag.pgm" "$ref"
+
+    for threads in 1 2 4; do
+        OMP_NUM_THREADS=$threads "$BIN/sobel_omp" "$size" > /dev/null
+        check "openmp $tag threads=$threads" "output/sobel_omp_$tag.pgm" "$ref"
+    done
+    for plan in serial threaded fused tiled; do
+        "$BIN/sobel_omp" "$size" --plan "$plan" --threads 3 --band 7 --tile 64 > /dev/null
+        check "openmp $tag plan=$plan" "output/sobel_omp_$tag.pgm" "$ref"
+    done
+
+    "$BIN/pgmcheck" ref "sample_$tag.pgm" "pyr_$tag.pgm" 3
+    "$BIN/sobel_omp" "$size" --pyramid 3 --threads 3 --band 5 > /dev/null 2>&1
+    check "openmp $tag pyramid level 0" "output/sobel_omp_$tag.pgm" "$ref"
+    for k in 1 2; do
+        [ -f "pyr_${tag}_L$k.pgm" ] || continue
+        check "openmp $tag pyramid level $k" "output/sobel_omp_${tag}_L$k.pgm" "pyr_${tag}_L$k.pgm"
+    done
+    rm -f pyr_"$tag"*.pgm
+
+    for bins in 4 8 256; do
+        "$BIN/sobel_omp" "$size" --orient "$bins" > /dev/null 2>&1
+        check "openmp $tag orient=$bins magnitude" "output/sobel_omp_$tag.pgm" "$ref"
+        if result=$("$BIN/pgmcheck" orient "sample_$tag.pgm" "output/sobel_omp_${tag}_dir.pgm" "$bins"); then
+            pass "openmp $tag orient=$bins direction"
+        else
+            fail "openmp $tag orient=$bins direction: $result"
+        fi
+        rm -f "output/sobel_omp_${tag}_dir.pgm"
+    done
+
+    "$BIN/pgmtile" to-tiled "sample_$tag.pgm" "sample_$tag.pgt" 64 > /dev/null &&
+        "$BIN/sobel_omp" "$size" --tiled > /dev/null &&
+        "$BIN/pgmtile" to-pgm "output/sobel_omp_$tag.pgt" "output/sobel_omp_tiled_$tag.pgm" > /dev/null
+    check "openmp $tag tiled file" "output/sobel_omp_tiled_$tag.pgm" "$ref"
+    rm -f "sample_$tag.pgt" "output/sobel_omp_$tag.pgt"
+
+    # Sparse edge list and mask against the thresholded reference
+    for threads in 1 3; do
+        OMP_NUM_THREADS=$threads "$BIN/sobel_omp" "$size" --edges 40 --mask > /dev/null 2>&1
+        if result=$("$BIN/pgmcheck" edges "sample_$tag.pgm" "output/sobel_omp_$tag.edg" \
+                    "output/sobel_omp_${tag}_mask.pbm" "$PIXEL_TOLERANCE"); then
+            pass "openmp $tag edges threads=$threads"
+        else
+            fail "openmp $tag edges threads=$threads: $result"
+        fi
+        rm -f "output/sobel_omp_$tag.edg" "output/sobel_omp_${tag}_mask.pbm"
+    done
+
+    if [ "$RUN_MPI" = 1 ]; then
+        for mode in static balanced shm; do
+            for np in $MPI_PROCS; do
+                $MPIRUN -n "$np" "$BIN/sobel_mpi" "$size" "$mode" 4 > /dev/null 2>&1
+                check "mpi $tag $mode np=$np" "output/sobel_mpi_$tag.pgm" "$ref"
+            done
+        done
+    fi
+done
+
+# Incremental frames: every frame must match a full run on that frame.
+# Frames 1 and 2 change a few small rectangles of the previous image (on the
+# top, left, right and bottom borders, one pair overlapping) and must only be
+# partly recomputed; frame 3 shares nothing with frame 2.
+echo "Incremental frames:"
+"$BIN/pgmcheck" patch sample_200.pgm frame_1.pgm 20 30 6 9 120 75 3 4 0 180 4 20 150 0 10 2
+"$BIN/pgmcheck" patch frame_1.pgm frame_2.pgm 196 90 4 30 60 60 10 10 65 65 10 10 80 199 5 1
+"$BIN/pgmcheck" gen 200 200 noise 7 frame_3.pgm
+for f in 1 2 3; do
+    "$BIN/pgmcheck" ref "frame_$f.pgm" "ref_frame_$f.pgm"
+done
+frames_log=$("$BIN/sobel" 200 frame_1.pgm frame_2.pgm frame_3.pgm)
+for f in 1 2 3; do
+    check "sequential incremental frame $f" "output/sobel_200_f$f.pgm" "ref_frame_$f.pgm"
+done
+for f in 1 2; do
+    line=$(echo "$frames_log" | grep "^Frame $f ")
+    if echo "$line" | grep -q "recomputed [0-9]* of 40000 pixels" && ! echo "$line" | grep -q "recomputed 40000 of"; then
+        pass "sequential incremental frame $f is partial"
+    else
+        fail "sequential incremental frame $f is not partial: $line"
+    fi
+done
+
+# Tiled regions: only the 64x64 tiles covering the region are filtered, and
+# inside the region they must match the full-image reference
+echo "Tiled regions:"
+# tag row col height width
+regions="257 40 70 100 90
+257 200 250 57 50
+97 90 120 7 11
+1k 0 0 70 1000"
+while read -r tag r c h w; do
+    size=$(size_of "$tag")
+    rm -f "output/sobel_omp_tiled_$tag.pgm"
+    "$BIN/pgmtile" to-tiled "sample_$tag.pgm" "sample_$tag.pgt" 64 > /dev/null &&
+        "$BIN/sobel_omp" "$size" --tiled "$r" "$c" "$h" "$w" > /dev/null &&
+        "$BIN/pgmtile" to-pgm "output/sobel_omp_$tag.pgt" "output/sobel_omp_tiled_$tag.pgm" > /dev/null
+    label="openmp $tag tiled region ${w}x$h+$c+$r"
+    if [ ! -f "output/sobel_omp_tiled_$tag.pgm" ]; then
+        fail "$label: no output"
+    elif result=$("$BIN/pgmcheck" diff "output/sobel_omp_tiled_$tag.pgm" "ref_$tag.pgm" \
+                  "$PIXEL_TOLERANCE" "$r" "$c" "$h" "$w"); then
+        pass "$label"
+    else
+        fail "$label: $result"
+    fi
+    rm -f "sample_$tag.pgt" "output/sobel_omp_$tag.pgt" "output/sobel_omp_tiled_$tag.pgm"
+done <<< "$regions"
+
+# Server: path and shared-memory jobs on one warm server
+echo "Server:"
+sock="$WORK/data/sobel.sock"
+"$BIN/sobel_server" serve "$sock" > server.log 2>&1 &
+server_pid=$!
+for i in $(seq 50); do
+    [ -S "$sock" ] && break
+    sleep 0.1
+done
+for tag in 97 257; do
+    "$BIN/sobel_server" run "$sock" "sample_$tag.pgm" "output/server_$tag.pgm" > /dev/null
+    check "server $tag path" "output/server_$tag.pgm" "ref_$tag.pgm"
+    "$BIN/sobel_server" run-shm "$sock" "sample_$tag.pgm" "output/server_$tag.pgm" 3 > /dev/null
+    check "server $tag shm" "output/server_$tag.pgm" "ref_$tag.pgm"
+done
+# A client that sends part of a request and stalls must not hold up others
+if command -v python3 > /dev/null; then
+    python3 -c 'import socket, sys, time
+s = socket.socket(socket.AF_UNIX)
+s.connect(sys.argv[1])
+s.send(b"x" * 10)
+time.sleep(10)' "$sock" &
+    stall_pid=$!
+    sleep 0.2
+    if timeout 5 "$BIN/sobel_server" stats "$sock" > /dev/null; then
+        pass "server answers while a client stalls mid-request"
+    else
+        fail "server blocked by a client stalled mid-request"
+    fi
+    kill "$stall_pid" 2> /dev/null
+    wait "$stall_pid" 2> /dev/null
+fi
+"$BIN/sobel_server" stop "$sock" > /dev/null
+wait "$server_pid"
+
+# ===================================================================
+# Performance against stored baselines (sizes present in the CSVs)
+# ===================================================================
+
+# Median of the numbers on stdin
+median() {
+    sort -g | awk '{ v[NR] = $1 } END { if (NR == 0) print ""; else if (NR % 2) print v[(NR + 1) / 2]; else print (v[NR / 2] + v[NR / 2 + 1]) / 2 }'
+}
+
+# Baseline median for the CSV row whose leading columns equal <key>
+baseline() {
+    local csv="$BASELINE_DIR/$1" key=$2
+    [ -n "$BASELINE_DIR" ] && [ -f "$csv" ] || return
+    awk -F, -v key="$key" 'NR > 1 {
+        n = split(key, k, ",")
+        for (i = 1; i <= n; i++) if ($i != k[i]) next
+        for (i = n + 1; i <= NF; i++) print $i
+    }' "$csv" | median
+}
+
+# perf <csv> <key> <label> <time> <time> <time>
+perf() {
+    local csv=$1 key=$2 label=$3
+    shift 3
+    local measured base verdict
+    measured=$(printf "%s\n" "$@" | median)
+    if [ -n "$RECORD_DIR" ]; then
+        echo "$key,$(IFS=,; echo "$*")" >> "$RECORD_DIR/$csv"
+    fi
+    base=$(baseline "$csv" "$key")
+    if [ -z "$base" ]; then
+        printf "  SKIP  %s: %.6f s (no baseline)\n" "$label" "$measured"
+        return
+    fi
+    verdict=$(awk -v m="$measured" -v b="$base" -v t="$PERF_TOLERANCE" 'BEGIN { print (m <= b * (1 + t)) ? "ok" : "slow" }')
+    local detail
+    detail=$(awk -v m="$measured" -v b="$base" 'BEGIN { printf "%.6f s vs baseline %.6f s (%+.1f%%)", m, b, (m / b - 1) * 100 }')
+    if [ "$verdict" = ok ]; then
+        pass "$label: $detail"
+    else
+        fail "$label: $detail"
+    fi
+}
+
+# Times of three runs of a command, from its "completed in" / "Time:" line
+times_of() {
+    for run in 1 2 3; do
+        "$@" 2> /dev/null | sed -n -e 's/.*completed in \([0-9.]*\) seconds.*/\1/p' -e 's/.*Time: \([0-9.]*\) seconds.*/\1/p'
+    done
+}
+
+# How the timed programs were built: the compiler flags, plus any source
+# file that raises its own optimisation level
+build_config() {
+    local overrides
+    overrides=$(cd "$ROOT" && grep -l -E 'pragma GCC optimize|__attribute__ *\(\(optimize' \
+                *.c *.cpp *.h *.hpp 2> /dev/null | tr '\n' ' ')
+    echo "flags=${BUILD_FLAGS:-none}"
+    echo "optimize_overrides=${overrides:-none}"
+}
+
+if [ "$RUN_PERF" = 1 ] && [ -n "$BASELINE_DIR" ]; then
+    if [ ! -f "$BASELINE_DIR/build.conf" ]; then
+        fail "perf: $BASELINE_DIR/build.conf missing, cannot tell how the baselines were built"
+        BASELINE_DIR=""
+    elif ! diff <(grep -v '^#' "$BASELINE_DIR/build.conf") <(build_config) > /dev/null; then
+        fail "perf: build differs from $BASELINE_DIR/build.conf ($(build_config | tr '\n' ' ')), not comparing"
+        BASELINE_DIR=""
+    fi
+fi
+if [ "$RUN_PERF" = 1 ] && [ -z "$BASELINE_DIR" ] && [ -z "$RECORD_DIR" ]; then
+    echo ""
+    echo "Performance: skipped (set BASELINE_DIR, e.g. BASELINE_DIR=report on the"
+    echo "course cluster, or pass --record DIR to time this machine)"
+    RUN_PERF=0
+fi
+if [ "$RUN_PERF" = 1 ]; then
+    echo ""
+    echo "=========================================="
+    if [ -n "$BASELINE_DIR" ]; then
+        echo "Performance (tolerance: +$(awk -v t="$PERF_TOLERANCE" 'BEGIN { print t * 100 }')% over $BASELINE_DIR)"
+    else
+        echo "Performance (recording to $RECORD_DIR, no baselines)"
+    fi
+    echo "=========================================="
+    cores=$(nproc)
+    if [ -n "$RECORD_DIR" ]; then
+        mkdir -p "$RECORD_DIR"
+        echo "image_size,run1_time,run2_time,run3_time" > "$RECORD_DIR/sequential_times.csv"
+        echo "image_size,threads,run1_time,run2_time,run3_time" > "$RECORD_DIR/openmp_times.csv"
+        echo "image_size,nodes,processes,run1_time,run2_time,run3_time" > "$RECORD_DIR/mpi_times.csv"
+        { echo "# Build of the timings in this directory (see test_regression.sh)"; build_config; } > "$RECORD_DIR/build.conf"
+    fi
+    for tag in 256 1024 4k 16k; do
+        [ -f "sample_$tag.pgm" ] || continue
+        size=$(size_of "$tag")
+        perf sequential_times.csv "$size" "sequential $tag" $(times_of "$BIN/sobel" "$size")
+        for threads in 1 2 4 8 16 32; do
+            [ "$threads" -le "$cores" ] || break
+            perf openmp_times.csv "$size,$threads" "openmp $tag threads=$threads" \
+                $(OMP_NUM_THREADS=$threads times_of "$BIN/sobel_omp" "$size")
+        done
+        if [ "$RUN_MPI" = 1 ]; then
+            for np in 1 2 4; do
+                [ "$np" -le "$cores" ] || break
+                perf mpi_times.csv "$size,1,$np" "mpi $tag np=$np" $(times_of $MPIRUN -n "$np" "$BIN/sobel_mpi" "$size")
+            done
+        fi
+    done
+    rm -f output/*.pgm
+fi
+
+# ===================================================================
+# Summary
+# ===================================================================
+echo ""
+echo "=========================================="
+echo "Passed: $passed | Failed: $failed"
+echo "=========================================="
+for f in "${failures[@]}"; do
+    echo "  $f"
+done
+[ "$failed" = 0 ]
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Tiled 8-bit grayscale container (.pgt) for random-access region reads
+//
+// Layout (all integers little-endian):
+//   char     magic[4]     "PGT1"
+//   uint32   width, height, tile_w, tile_h
+//   uint64   index[tiles_y * tiles_x]   byte offset of each tile, row-major
+//   uint8    tiles[]                    tile_w * tile_h raw pixels each;
+//                                       edge tiles are zero-padded
+// Tiles are fixed size, so every tile can be read or written on its own with
+// pread/pwrite, from any thread or process.
+
+#define TILE_MAGIC "PGT1"
+#define TILE_DEFAULT_SIZE 256
+#define TILE_HEADER_BYTES 20
+
+typedef struct {
+    int fd;
+    int rows, cols;
+    int tile_h, tile_w;
+    int tiles_y, tiles_x;
+    uint64_t *index;
+} tiled_image;
+
+static void tile_put_u32(unsigned char *p, uint32_t v) {
+    for (int k = 0; k < 4; k++) p[k] = (unsigned char)(v >> (8 * k));
+}
+
+static uint32_t tile_get_u32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int k = 0; k < 4; k++) v |= (uint32_t)p[k] << (8 * k);
+    return v;
+}
+
+// Create an empty tiled image; all tiles read as 0 until written
+int tileio_create(const char *filename, int rows, int cols, int tile_h, int tile_w, tiled_image *t) {
+    t->rows = rows;
+    t->cols = cols;
+    t->tile_h = tile_h;
+    t->tile_w = tile_w;
+    t->tiles_y = (rows + tile_h - 1) / tile_h;
+    t->tiles_x = (cols + tile_w - 1) / tile_w;
+
+    size_t num_tiles = (size_t)t->tiles_y * t->tiles_x;
+    size_t header_size = TILE_HEADER_BYTES + num_tiles * 8;
+    size_t tile_bytes = (size_t)tile_h * tile_w;
+
+    t->index = (uint64_t *)malloc(num_tiles * sizeof(uint64_t));
+    unsigned char *header = (unsigned char *)malloc(header_size);
+    if (!t->index || !header) { free(t->index); free(header); return -1; }
+
+    memcpy(header, TILE_MAGIC, 4);
+    tile_put_u32(header + 4, (uint32_t)cols);
+    tile_put_u32(header + 8, (uint32_t)rows);
+    tile_put_u32(header + 12, (uint32_t)tile_w);
+    tile_put_u32(header + 16, (uint32_t)tile_h);
+    for (size_t k = 0; k < num_tiles; k++) {
+        t->index[k] = header_size + k * tile_bytes;
+        tile_put_u32(header + TILE_HEADER_BYTES + 8 * k, (uint32_t)(t->index[k] & 0xffffffffu));
+        tile_put_u32(header + TILE_HEADER_BYTES + 8 * k + 4, (uint32_t)(t->index[k] >> 32));
+    }
+
+    t->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (t->fd < 0) { perror("open"); free(t->index); free(header); return -1; }
+
+    int ok = pwrite(t->fd, header, header_size, 0) == (ssize_t)header_size &&
+             ftruncate(t->fd, (off_t)(header_size + num_tiles * tile_bytes)) == 0;
+    free(header);
+    if (!ok) { close(t->fd); free(t->index); return -1; }
+    return 0;
+}
+
+// Open an existing tiled image (header and index only; no pixel data is read)
+int tileio_open(const char *filename, tiled_image *t) {
+    t->fd = open(filename, O_RDONLY);
+    if (t->fd < 0) { perror("open"); return -1; }
+
+    unsigned char fixed[TILE_HEADER_BYTES];
+    if (pread(t->fd, fixed, sizeof(fixed), 0) != (ssize_t)sizeof(fixed) ||
+        memcmp(fixed, TILE_MAGIC, 4) != 0) {
+        close(t->fd);
+        return -1;
+    }
+    t->cols = (int)tile_get_u32(fixed + 4);
+    t->rows = (int)tile_get_u32(fixed + 8);
+    t->tile_w = (int)tile_get_u32(fixed + 12);
+    t->tile_h = (int)tile_get_u32(fixed + 16);
+    if (t->tile_w <= 0 || t->tile_h <= 0) { close(t->fd); return -1; }
+    t->tiles_y = (t->rows + t->tile_h - 1) / t->tile_h;
+    t->tiles_x = (t->cols + t->tile_w - 1) / t->tile_w;
+
+    size_t num_tiles = (size_t)t->tiles_y * t->tiles_x;
+    unsigned char *raw = (unsigned char *)malloc(num_tiles * 8);
+    t->index = (uint64_t *)malloc(num_tiles * sizeof(uint64_t));
+    if (!raw || !t->index ||
+        pread(t->fd, raw, num_tiles * 8, TILE_HEADER_BYTES) != (ssize_t)(num_tiles * 8)) {
+        free(raw);
+        free(t->index);
+        close(t->fd);
+        return -1;
+    }
+    for (size_t k = 0; k < num_tiles; k++) {
+        t->index[k] = (uint64_t)tile_get_u32(raw + 8 * k) | ((uint64_t)tile_get_u32(raw + 8 * k + 4) << 32);
+    }
+    free(raw);
+    return 0;
+}
+
+void tileio_close(tiled_image *t) {
+    close(t->fd);
+    free(t->index);
+    t->index = NULL;
+}
+
+// Read the region [r0, r0+h) x [c0, c0+w) into 'out' (h x w floats).
+// Only the tiles overlapping the region are touched.
+int tileio_read_region(const tiled_image *t, int r0, int c0, int h, int w, float *out) {
+    size_t tile_bytes = (size_t)t->tile_h * t->tile_w;
+    unsigned char *buf = (unsigned char *)malloc(tile_bytes);
+    if (!buf) return -1;
+
+    int ty0 = r0 / t->tile_h, ty1 = (r0 + h - 1) / t->tile_h;
+    int tx0 = c0 / t->tile_w, tx1 = (c0 + w - 1) / t->tile_w;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            if (pread(t->fd, buf, tile_bytes, (off_t)t->index[(size_t)ty * t->tiles_x + tx]) != (ssize_t)tile_bytes) {
+                free(buf);
+                return -1;
+            }
+            // Overlap of this tile with the region, in image coordinates
+            int i0 = ty * t->tile_h > r0 ? ty * t->tile_h : r0;
+            int i1 = (ty + 1) * t->tile_h < r0 + h ? (ty + 1) * t->tile_h : r0 + h;
+            int j0 = tx * t->tile_w > c0 ? tx * t->tile_w : c0;
+            int j1 = (tx + 1) * t->tile_w < c0 + w ? (tx + 1) * t->tile_w : c0 + w;
+            for (int i = i0; i < i1; i++) {
+                const unsigned char *src = buf + (size_t)(i - ty * t->tile_h) * t->tile_w + (j0 - tx * t->tile_w);
+                float *dst = out + (size_t)(i - r0) * w + (j0 - c0);
+                for (int j = 0; j < j1 - j0; j++) dst[j] = (float)src[j];
+            }
+        }
+    }
+    free(buf);
+    return 0;
+}
+
+// Write tile (ty, tx) from a float image 'img' of width img_cols whose
+// top-left pixel is image coordinate (img_r0, img_c0). Pixels are rounded
+// and clamped like pgmwrite. Safe to call concurrently for different tiles.
+int tileio_write_tile(const tiled_image *t, int ty, int tx, const float *img, int img_r0, int img_c0, int img_cols) {
+    size_t tile_bytes = (size_t)t->tile_h * t->tile_w;
+    unsigned char *buf = (unsigned char *)calloc(tile_bytes, 1);
+    if (!buf) return -1;
+
+    int i1 = (ty + 1) * t->tile_h < t->rows ? (ty + 1) * t->tile_h : t->rows;
+    int j1 = (tx + 1) * t->tile_w < t->cols ? (tx + 1) * t->tile_w : t->cols;
+    int j0 = tx * t->tile_w;
+    for (int i = ty * t->tile_h; i < i1; i++) {
+        const float *src = img + (size_t)(i - img_r0) * img_cols + (j0 - img_c0);
+        unsigned char *dst = buf + (size_t)(i - ty * t->tile_h) * t->tile_w;
+        for (int j = 0; j < j1 - j0; j++) {
+            int val = (int)(src[j] + 0.5f);
+            if (val < 0) val = 0;
+            if (val > 255) val = 255;
+            dst[j] = (unsigned char)val;
+        }
+    }
+
+    int ok = pwrite(t->fd, buf, tile_bytes, (off_t)t->index[(size_t)ty * t->tiles_x + tx]) == (ssize_t)tile_bytes;
+    free(buf);
+    return ok ? 0 : -1;
+}